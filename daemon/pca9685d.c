@@ -0,0 +1,649 @@
+/*
+MIT License
+
+Copyright (c) 2024 Giuseppe Giglio <g.giglio001@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * \file pca9685d.c
+ * \brief This file contains the pca9685d daemon, which owns the PCA9685 boards
+ *       and serves the other processes through shared-memory frame buffers and
+ *       a Unix socket.
+ *
+ * Usage: pca9685d -d BUS:ADDR [-d BUS:ADDR ...] [-r RATE_HZ] [-s SOCKET_PATH]
+ *                 [-b SCRUB_US_PER_S] [-i IDLE_MS]
+ *
+ * Every tick, the channels written to the frame buffer of a board and the
+ * channels set by the socket clients since the previous tick are merged into
+ * a single frame, committed to the board in one flush.
+ *
+ * Safety requests are run as soon as they are read, ahead of the tick. Client
+ * requests are served before the tick of the same poll round, so a safety
+ * request waits at most for the flush of one tick.
+ *
+ * With -b, the boards are verified against their shadow copy after each tick,
+ * spending at most SCRUB_US_PER_S microseconds of bus time per second. Repaired
+ * channels and restored boards are reported on stderr.
+ *
+ * With -i, a board whose channels are all known to be off and that was not
+ * written for IDLE_MS milliseconds is put to sleep. It is woken up by the next
+ * commit turning one of its channels on.
+ */
+
+/* Standard library includes */
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+
+/* Local includes */
+#include "pca9685lib.h"
+#include "pca9685proto.h"
+#include "pca9685scrub.h"
+#include "pca9685shm.h"
+
+/* Macros */
+
+#define PCA9685D_MAX_BOARDS (16U)
+#define PCA9685D_MAX_CLIENTS (64U)
+#define PCA9685D_DEFAULT_RATE_HZ (100U)
+
+/* Poll descriptors ahead of the clients */
+#define PCA9685D_POLL_LISTEN (0U)
+#define PCA9685D_POLL_TIMER (1U)
+#define PCA9685D_POLL_CLIENTS (2U)
+
+
+/* Typedefs */
+
+/**
+ * \struct PCA9685dBoard_t
+ * \brief This structure holds a board served by the daemon.
+*/
+typedef struct PCA9685dBoard_s
+{
+    PCA9685I2CConf_t conf; /** Board configuration data structure */
+    PCA9685ShmBuffer_t buffer; /** Board frame buffer */
+    uint16_t i2cDevNumber; /** Linux I2C dev number of the board bus */
+    uint8_t i2cAddress; /** I2C slave address of the board */
+    PCA9685Frame_t pending; /** Channels to write on the next tick */
+    PCA9685Frame_t current; /** Channels written so far, mask flags the known ones */
+    uint8_t stopped; /** Non-zero after a safety stop, until resumed */
+} PCA9685dBoard_t;
+
+/**
+ * \struct PCA9685dClient_t
+ * \brief This structure holds a socket client of the daemon.
+*/
+typedef struct PCA9685dClient_s
+{
+    int fd; /** Client socket, negative if the slot is free */
+    uint16_t subscribed[PCA9685D_MAX_BOARDS]; /** Channels watched on each board */
+} PCA9685dClient_t;
+
+
+/* Global variables */
+
+static volatile sig_atomic_t running = 1; /** Cleared by SIGINT and SIGTERM */
+
+static PCA9685dBoard_t boards[PCA9685D_MAX_BOARDS]; /** Served boards */
+static uint32_t boardCount = 0U; /** Number of served boards */
+
+static PCA9685dClient_t clients[PCA9685D_MAX_CLIENTS]; /** Socket clients */
+
+static PCA9685Scrubber_t scrubber; /** Board scrubber, budget is zero if disabled */
+
+
+/* Functions definitions */
+
+static void PCA9685dStop(int signum)
+{
+    (void) signum;
+    running = 0;
+}
+
+static void PCA9685dUsage(const char *program)
+{
+    fprintf(stderr, "Usage: %s -d BUS:ADDR [-d BUS:ADDR ...] [-r RATE_HZ] [-s SOCKET_PATH]"
+            " [-b SCRUB_US_PER_S] [-i IDLE_MS]\n", program);
+}
+
+static PCA9685dBoard_t *PCA9685dFindBoard(uint16_t i2cDevNumber, uint8_t i2cAddress)
+{
+    uint32_t i = 0U; /** Board index */
+
+    for (i = 0U; i < boardCount; i++)
+    {
+        if (boards[i].i2cDevNumber == i2cDevNumber && boards[i].i2cAddress == i2cAddress)
+        {
+            return &boards[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void PCA9685dDropClient(PCA9685dClient_t *client)
+{
+    close(client->fd);
+    client->fd = -1;
+}
+
+static void PCA9685dNotify(const PCA9685dBoard_t *board, uint16_t changed)
+{
+    uint8_t message[PCA9685_PROTO_MAX_SIZE]; /** Notification */
+    PCA9685ProtoHeader_t header; /** Notification header */
+    size_t size = 0U; /** Notification size */
+    uint32_t i = 0U; /** Client index */
+
+    memset(&header, 0, sizeof(header));
+    header.op = PCA9685_PROTO_OP_NOTIFY;
+    header.i2cAddress = board->i2cAddress;
+    header.i2cDevNumber = board->i2cDevNumber;
+
+    for (i = 0U; i < PCA9685D_MAX_CLIENTS; i++)
+    {
+        if (clients[i].fd < 0 || (clients[i].subscribed[board - boards] & changed) == 0U)
+        {
+            continue;
+        }
+
+        header.channelMask = clients[i].subscribed[board - boards] & changed;
+        size = PCA9685_ProtoPack(message, &header, &board->current);
+
+        /* A subscriber that does not keep up loses notifications, not the connection */
+        if (send(clients[i].fd, message, size, MSG_DONTWAIT | MSG_NOSIGNAL) < 0 
+                && errno != EAGAIN)
+        {
+            PCA9685dDropClient(&clients[i]);
+        }
+    }
+}
+
+static uint8_t PCA9685dSafety(const PCA9685ProtoHeader_t *header)
+{
+    PCA9685dBoard_t *board = NULL; /** Board being stopped or resumed */
+    uint8_t status = PCA9685_PROTO_STATUS_NO_BOARD; /** Reply status */
+    uint32_t i = 0U; /** Board index */
+
+    for (i = 0U; i < boardCount; i++)
+    {
+        board = &boards[i];
+
+        if (header->i2cAddress != PCA9685_PROTO_ALL_BOARDS 
+                && (board->i2cDevNumber != header->i2cDevNumber 
+                    || board->i2cAddress != header->i2cAddress))
+        {
+            continue;
+        }
+
+        status = (status == PCA9685_PROTO_STATUS_NO_BOARD) ? PCA9685_PROTO_STATUS_OK : status;
+
+        if (header->op == PCA9685_PROTO_OP_RESUME)
+        {
+            board->stopped = 0U;
+            continue;
+        }
+
+        board->stopped = 1U;
+        board->pending.channelMask = 0U;
+
+        if (PCA9685_SafetyStop(&board->conf, (uint8_t) header->channelMask) != PCA9685LIB_SUCCESS)
+        {
+            status = PCA9685_PROTO_STATUS_BUS_ERROR;
+        }
+
+        /* Channels turned off are reported like any other change */
+        if (PCA9685_GetPWMSnapshot(&board->conf, &board->current) == PCA9685LIB_SUCCESS)
+        {
+            PCA9685dNotify(board, board->current.channelMask);
+        }
+    }
+
+    return status;
+}
+
+static void PCA9685dServeClient(PCA9685dClient_t *client)
+{
+    uint8_t message[PCA9685_PROTO_MAX_SIZE]; /** Request, then reply */
+    PCA9685ProtoHeader_t header; /** Request header */
+    PCA9685Frame_t frame; /** Request channels */
+    PCA9685dBoard_t *board = NULL; /** Addressed board */
+    const PCA9685Frame_t *replyFrame = NULL; /** Reply channels */
+    ssize_t size = 0; /** Request size */
+    size_t replySize = 0U; /** Reply size */
+
+    size = recv(client->fd, message, sizeof(message), MSG_DONTWAIT);
+
+    if (size <= 0)
+    {
+        if (size == 0 || (errno != EAGAIN && errno != EINTR))
+        {
+            PCA9685dDropClient(client);
+        }
+        return;
+    }
+
+    if (PCA9685_ProtoUnpack(message, (size_t) size, &header, &frame) != PCA9685LIB_SUCCESS)
+    {
+        memset(&header, 0, sizeof(header));
+        header.status = PCA9685_PROTO_STATUS_BAD_REQUEST;
+    }
+    else if ((header.op == PCA9685_PROTO_OP_SAFETY || header.op == PCA9685_PROTO_OP_RESUME) 
+                && frame.channelMask == 0U)
+    {
+        header.status = PCA9685dSafety(&header);
+    }
+    else if ((board = PCA9685dFindBoard(header.i2cDevNumber, header.i2cAddress)) == NULL)
+    {
+        header.status = PCA9685_PROTO_STATUS_NO_BOARD;
+    }
+    else if (header.op == PCA9685_PROTO_OP_SET && frame.channelMask != 0U)
+    {
+        if (board->stopped != 0U)
+        {
+            header.status = PCA9685_PROTO_STATUS_STOPPED;
+        }
+        else
+        {
+            (void) PCA9685_FrameMerge(&board->pending, &frame);
+            header.status = PCA9685_PROTO_STATUS_OK;
+        }
+        header.channelMask = 0U;
+    }
+    else if (header.op == PCA9685_PROTO_OP_GET && frame.channelMask == 0U)
+    {
+        header.status = PCA9685_PROTO_STATUS_OK;
+        header.channelMask &= board->current.channelMask;
+        replyFrame = &board->current;
+    }
+    else if (header.op == PCA9685_PROTO_OP_SUBSCRIBE && frame.channelMask == 0U)
+    {
+        client->subscribed[board - boards] = header.channelMask;
+        header.status = PCA9685_PROTO_STATUS_OK;
+    }
+    else
+    {
+        header.status = PCA9685_PROTO_STATUS_BAD_REQUEST;
+    }
+
+    replySize = PCA9685_ProtoPack(message, &header, replyFrame);
+
+    if (send(client->fd, message, replySize, MSG_DONTWAIT | MSG_NOSIGNAL) != (ssize_t) replySize)
+    {
+        PCA9685dDropClient(client);
+    }
+}
+
+static void PCA9685dTick(void)
+{
+    PCA9685dBoard_t *board = NULL; /** Board being flushed */
+    uint32_t i = 0U; /** Board index */
+
+    for (i = 0U; i < boardCount; i++)
+    {
+        board = &boards[i];
+
+        /* A locked buffer is taken on a later tick */
+        (void) PCA9685_ShmTake(&board->buffer, &board->pending);
+
+        /* Stopped boards drop their channels instead of applying them on resume */
+        if (board->stopped != 0U)
+        {
+            board->pending.channelMask = 0U;
+        }
+
+        /* Quarantined boards keep their channels pending until their retry time */
+        if (PCA9685_IsQuarantined(&board->conf) != 0U)
+        {
+            continue;
+        }
+
+        /* Idle boards with every channel off are put to sleep, failures are retried on the next tick */
+        if (board->pending.channelMask == 0U)
+        {
+            (void) PCA9685_AutoSleepPoll(&board->conf);
+            continue;
+        }
+
+        /* Failures are retried on the next tick, the pending channels are kept */
+        if (PCA9685_CommitFrame(&board->conf, &board->pending) == PCA9685LIB_SUCCESS)
+        {
+            (void) PCA9685_FrameMerge(&board->current, &board->pending);
+            PCA9685dNotify(board, board->pending.channelMask);
+            board->pending.channelMask = 0U;
+        }
+    }
+}
+
+static void PCA9685dScrub(void)
+{
+    uint16_t repaired[PCA9685D_MAX_BOARDS]; /** Channels repaired on each board */
+    uint32_t i = 0U; /** Board index */
+
+    if (scrubber.budgetNs == 0U)
+    {
+        return;
+    }
+
+    /* Failed slices are counted in the statistics and retried on the next pass */
+    (void) PCA9685_ScrubTick(&scrubber, repaired);
+
+    for (i = 0U; i < boardCount; i++)
+    {
+        if (repaired[i] == PCA9685_SCRUB_RESTORED)
+        {
+            fprintf(stderr, "pca9685d: board %u:%02x lost its state, restored\n", 
+                    (unsigned int) boards[i].i2cDevNumber, (unsigned int) boards[i].i2cAddress);
+        }
+        else if (repaired[i] != 0U)
+        {
+            fprintf(stderr, "pca9685d: board %u:%02x channels %04x corrupted, repaired\n", 
+                    (unsigned int) boards[i].i2cDevNumber, (unsigned int) boards[i].i2cAddress, 
+                    (unsigned int) repaired[i]);
+        }
+    }
+}
+
+static int PCA9685dListen(const char *socketPath)
+{
+    struct sockaddr_un address; /** Socket address */
+    int fd = -1; /** Listening socket */
+
+    if (strlen(socketPath) >= sizeof(address.sun_path))
+    {
+        return -1;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socketPath);
+
+    fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    (void) unlink(socketPath);
+
+    if (bind(fd, (struct sockaddr *) &address, sizeof(address)) != 0 
+            || listen(fd, (int) PCA9685D_MAX_CLIENTS) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static int PCA9685dTimer(unsigned long rate)
+{
+    struct itimerspec period; /** Tick period */
+    int fd = -1; /** Timer descriptor */
+
+    fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    period.it_interval.tv_sec = (time_t) (1UL / rate);
+    period.it_interval.tv_nsec = (long) ((1000000000UL / rate) % 1000000000UL);
+    period.it_value = period.it_interval;
+
+    if (timerfd_settime(fd, 0, &period, NULL) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+int main(int argc, char *argv[])
+{
+    struct pollfd pfds[PCA9685D_POLL_CLIENTS + PCA9685D_MAX_CLIENTS]; /** Poll descriptors */
+    const char *socketPath = PCA9685_PROTO_SOCKET_PATH; /** Socket path */
+    unsigned long rate = PCA9685D_DEFAULT_RATE_HZ; /** Tick rate */
+    unsigned long scrubUs = 0UL; /** Scrubbing bus time per second, in microseconds */
+    unsigned long idleMs = 0UL; /** Auto-sleep idle time, in milliseconds */
+    unsigned int bus = 0U; /** Parsed bus */
+    unsigned int addr = 0U; /** Parsed address */
+    uint64_t expirations = 0U; /** Timer expirations */
+    struct sigaction action; /** Termination signals handler */
+    uint32_t opened = 0U; /** Number of boards opened */
+    uint32_t i = 0U; /** Board or client index */
+    int listenFd = -1; /** Listening socket */
+    int timerFd = -1; /** Tick timer */
+    int fd = -1; /** Accepted socket */
+    int option = 0; /** Command line option */
+    int status = EXIT_SUCCESS; /** Exit status */
+
+    while ((option = getopt(argc, argv, "d:r:s:b:i:")) != -1)
+    {
+        switch (option)
+        {
+            case 'd':
+                if (boardCount >= PCA9685D_MAX_BOARDS 
+                        || sscanf(optarg, "%u:%x", &bus, &addr) != 2 
+                        || addr > 0x7FU)
+                {
+                    PCA9685dUsage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                boards[boardCount].i2cDevNumber = (uint16_t) bus;
+                boards[boardCount].i2cAddress = (uint8_t) addr;
+                boardCount++;
+                break;
+            case 'r':
+                rate = strtoul(optarg, NULL, 10);
+                if (rate == 0UL || rate > 1000000UL)
+                {
+                    PCA9685dUsage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 's':
+                socketPath = optarg;
+                break;
+            case 'b':
+                scrubUs = strtoul(optarg, NULL, 10);
+                if (scrubUs > 1000000UL)
+                {
+                    PCA9685dUsage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'i':
+                idleMs = strtoul(optarg, NULL, 10);
+                if (idleMs > 86400000UL)
+                {
+                    PCA9685dUsage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            default:
+                PCA9685dUsage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (boardCount == 0U)
+    {
+        PCA9685dUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = PCA9685dStop;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    for (i = 0U; i < PCA9685D_MAX_CLIENTS; i++)
+    {
+        clients[i].fd = -1;
+    }
+
+    for (opened = 0U; opened < boardCount; opened++)
+    {
+        PCA9685dBoard_t *board = &boards[opened]; /** Board being opened */
+
+        board->pending.channelMask = 0U;
+        board->current.channelMask = 0U;
+        board->stopped = 0U;
+
+        if (PCA9685_Init(&board->conf, board->i2cAddress, board->i2cDevNumber) != PCA9685LIB_SUCCESS)
+        {
+            fprintf(stderr, "pca9685d: cannot open board %u:%02x\n", 
+                    (unsigned int) board->i2cDevNumber, (unsigned int) board->i2cAddress);
+            status = EXIT_FAILURE;
+            break;
+        }
+
+        if (PCA9685_WakeUp(&board->conf) != PCA9685LIB_SUCCESS 
+                || PCA9685_ShmCreate(&board->buffer, board->i2cDevNumber, 
+                                        board->i2cAddress) != PCA9685LIB_SUCCESS)
+        {
+            fprintf(stderr, "pca9685d: cannot set up board %u:%02x\n", 
+                    (unsigned int) board->i2cDevNumber, (unsigned int) board->i2cAddress);
+            PCA9685_Close(&board->conf);
+            status = EXIT_FAILURE;
+            break;
+        }
+
+        /* Woken up again by the first commit turning a channel on */
+        (void) PCA9685_SetAutoSleep(&board->conf, (uint32_t) idleMs);
+    }
+
+    /* Boards were added in order, so repaired entries match the board table */
+    (void) PCA9685_ScrubInit(&scrubber, PCA9685_SCRUB_DEFAULT_SLICE, (uint32_t) (scrubUs * 1000UL));
+
+    for (i = 0U; i < opened; i++)
+    {
+        (void) PCA9685_ScrubAddBoard(&scrubber, &boards[i].conf);
+    }
+
+    if (status == EXIT_SUCCESS)
+    {
+        listenFd = PCA9685dListen(socketPath);
+        timerFd = PCA9685dTimer(rate);
+
+        if (listenFd < 0 || timerFd < 0)
+        {
+            fprintf(stderr, "pca9685d: cannot set up %s\n", socketPath);
+            status = EXIT_FAILURE;
+        }
+    }
+
+    while (running && status == EXIT_SUCCESS)
+    {
+        pfds[PCA9685D_POLL_LISTEN].fd = listenFd;
+        pfds[PCA9685D_POLL_LISTEN].events = POLLIN;
+        pfds[PCA9685D_POLL_TIMER].fd = timerFd;
+        pfds[PCA9685D_POLL_TIMER].events = POLLIN;
+
+        for (i = 0U; i < PCA9685D_MAX_CLIENTS; i++)
+        {
+            /* Free slots have a negative descriptor, which poll ignores */
+            pfds[PCA9685D_POLL_CLIENTS + i].fd = clients[i].fd;
+            pfds[PCA9685D_POLL_CLIENTS + i].events = POLLIN;
+            pfds[PCA9685D_POLL_CLIENTS + i].revents = 0;
+        }
+
+        if (poll(pfds, PCA9685D_POLL_CLIENTS + PCA9685D_MAX_CLIENTS, -1) < 0)
+        {
+            continue;
+        }
+
+        /* Serving the requests first so that they make this tick */
+        for (i = 0U; i < PCA9685D_MAX_CLIENTS; i++)
+        {
+            if (clients[i].fd >= 0 && pfds[PCA9685D_POLL_CLIENTS + i].revents != 0)
+            {
+                PCA9685dServeClient(&clients[i]);
+            }
+        }
+
+        if ((pfds[PCA9685D_POLL_TIMER].revents & POLLIN) != 0 
+                && read(timerFd, &expirations, sizeof(expirations)) == sizeof(expirations))
+        {
+            PCA9685dTick();
+            PCA9685dScrub();
+        }
+
+        if ((pfds[PCA9685D_POLL_LISTEN].revents & POLLIN) != 0)
+        {
+            fd = accept(listenFd, NULL, NULL);
+
+            for (i = 0U; fd >= 0 && i < PCA9685D_MAX_CLIENTS; i++)
+            {
+                if (clients[i].fd < 0)
+                {
+                    memset(&clients[i], 0, sizeof(clients[i]));
+                    clients[i].fd = fd;
+                    fd = -1;
+                }
+            }
+
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+        }
+    }
+
+    for (i = 0U; i < PCA9685D_MAX_CLIENTS; i++)
+    {
+        if (clients[i].fd >= 0)
+        {
+            PCA9685dDropClient(&clients[i]);
+        }
+    }
+
+    if (listenFd >= 0)
+    {
+        close(listenFd);
+        (void) unlink(socketPath);
+    }
+
+    if (timerFd >= 0)
+    {
+        close(timerFd);
+    }
+
+    for (i = 0U; i < opened; i++)
+    {
+        PCA9685_ShmClose(&boards[i].buffer);
+        PCA9685_Close(&boards[i].conf);
+    }
+
+    return status;
+}
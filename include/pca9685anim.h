@@ -0,0 +1,156 @@
+/*
+MIT License
+
+Copyright (c) 2024 Giuseppe Giglio <g.giglio001@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * \file pca9685anim.h
+ * \brief This file contains the declarations of the keyframe animation engine
+ *       that drives PCA9685 channels from per-channel tracks.
+ */
+
+#ifndef PCA9685ANIM_H
+#define PCA9685ANIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Standard library includes */
+#include <stdint.h>
+
+/* Local includes */
+#include "pca9685lib.h"
+
+/* Macros */
+
+/* Keyframe interpolation modes */
+#define PCA9685_ANIM_STEP ((uint8_t) 0U) /** Hold the keyframe value until the next one */
+#define PCA9685_ANIM_LINEAR ((uint8_t) 1U) /** Linear interpolation */
+#define PCA9685_ANIM_CUBIC ((uint8_t) 2U) /** Catmull-Rom spline through neighbouring keyframes */
+#define PCA9685_ANIM_EASE_IN ((uint8_t) 3U) /** Quadratic ease in */
+#define PCA9685_ANIM_EASE_OUT ((uint8_t) 4U) /** Quadratic ease out */
+#define PCA9685_ANIM_EASE_IN_OUT ((uint8_t) 5U) /** Smoothstep ease in and out */
+
+/* Fixed-point precision of the segment position */
+#define PCA9685_ANIM_FRAC_BITS (16U)
+#define PCA9685_ANIM_ONE ((uint32_t) 1U << PCA9685_ANIM_FRAC_BITS)
+
+
+/* Typedefs */
+
+/**
+ * \struct PCA9685Keyframe_t "pca9685anim.h" pca9685anim.h
+ * \brief This structure holds a keyframe of a channel track.
+*/
+typedef struct PCA9685Keyframe_s
+{
+    uint32_t timeMs; /** Time of the keyframe from the start of the track */
+    uint16_t value; /** Duty cycle, from 0 to PCA9685_MAX_PWM_VALUE */
+    uint8_t interp; /** Interpolation of the segment starting at this keyframe */
+} PCA9685Keyframe_t;
+
+/**
+ * \struct PCA9685AnimTrack_t "pca9685anim.h" pca9685anim.h
+ * \brief This structure holds the playback state of a channel track.
+*/
+typedef struct PCA9685AnimTrack_s
+{
+    const PCA9685Keyframe_t *keys; /** Keyframes, sorted by time */
+    uint16_t keyCount; /** Number of keyframes */
+    uint16_t cursor; /** Keyframe starting the segment being played */
+    uint32_t startMs; /** Animation time at which the track was started */
+    uint8_t board; /** Board index in the animation board table */
+    uint8_t channel; /** PWM channel number */
+    uint8_t loop; /** Non-zero to restart the track once its last keyframe is reached */
+    uint8_t active; /** Non-zero while the track is playing */
+} PCA9685AnimTrack_t;
+
+/**
+ * \struct PCA9685Anim_t "pca9685anim.h" pca9685anim.h
+ * \brief This structure holds an animation. Every buffer is provided by the caller,
+ *        so ticking the animation never allocates.
+*/
+typedef struct PCA9685Anim_s
+{
+    PCA9685I2CConf_t **boards; /** Boards driven by the animation */
+    PCA9685Frame_t *frames; /** One frame per board, filled at each tick */
+    uint8_t boardCount; /** Number of boards */
+    PCA9685AnimTrack_t *tracks; /** Track slots */
+    uint16_t trackCount; /** Number of track slots */
+} PCA9685Anim_t;
+
+
+/* Functions declarations */
+
+/**
+ * \brief This function initializes an animation over caller-provided buffers.
+ * \param [out] anim -- Pointer to the animation.
+ * \param [in] boards -- Array of boards driven by the animation.
+ * \param [in] frames -- Array of boardCount frames used at each tick.
+ * \param [in] boardCount -- Number of boards.
+ * \param [in] tracks -- Array of track slots.
+ * \param [in] trackCount -- Number of track slots.
+ * \returns PCA9685LIB_SUCCESS if the animation is successfully initialized, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_AnimInit(PCA9685Anim_t *anim, PCA9685I2CConf_t **boards, PCA9685Frame_t *frames, 
+                            uint8_t boardCount, PCA9685AnimTrack_t *tracks, uint16_t trackCount);
+
+/**
+ * \brief This function starts a track on a channel.
+ * \param [in] anim -- Pointer to the animation.
+ * \param [in] track -- Track slot index.
+ * \param [in] board -- Board index in the animation board table.
+ * \param [in] channel -- PWM channel number.
+ * \param [in] keys -- Keyframes, sorted by time. Must stay valid while the track plays.
+ * \param [in] keyCount -- Number of keyframes.
+ * \param [in] loop -- Non-zero to loop the track.
+ * \param [in] nowMs -- Current animation time.
+ * \returns PCA9685LIB_SUCCESS if the track is successfully started, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_AnimStartTrack(PCA9685Anim_t *anim, uint16_t track, uint8_t board, uint8_t channel, 
+                                const PCA9685Keyframe_t *keys, uint16_t keyCount, uint8_t loop, 
+                                uint32_t nowMs);
+
+/**
+ * \brief This function stops a track. The channel keeps its last value.
+ * \param [in] anim -- Pointer to the animation.
+ * \param [in] track -- Track slot index.
+ * \returns PCA9685LIB_SUCCESS if the track is successfully stopped, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_AnimStopTrack(PCA9685Anim_t *anim, uint16_t track);
+
+/**
+ * \brief This function evaluates every active track at the given time and commits
+ *        one frame per board. Non-looping tracks stop after their last keyframe.
+ * \param [in] anim -- Pointer to the animation.
+ * \param [in] nowMs -- Current animation time.
+ * \returns PCA9685LIB_SUCCESS if every board is successfully committed, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_AnimTick(PCA9685Anim_t *anim, uint32_t nowMs);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCA9685ANIM_H
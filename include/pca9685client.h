@@ -0,0 +1,155 @@
+/*
+MIT License
+
+Copyright (c) 2024 Giuseppe Giglio <g.giglio001@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * \file pca9685client.h
+ * \brief This file contains the declarations of the pca9685d client functions.
+ *
+ * A connection waiting for a reply drops the notifications it receives
+ * meanwhile, subscribers should use a connection of their own.
+ */
+
+#ifndef PCA9685CLIENT_H
+#define PCA9685CLIENT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Standard library includes */
+#include <stdint.h>
+
+/* Local includes */
+#include "pca9685lib.h"
+#include "pca9685proto.h"
+
+
+/* Typedefs */
+
+/**
+ * \struct PCA9685Client_t "pca9685client.h" pca9685client.h
+ * \brief This structure holds a connection to the pca9685d daemon.
+*/
+typedef struct PCA9685Client_s
+{
+    int fd; /** Socket descriptor */
+    uint8_t status; /** PCA9685_PROTO_STATUS_* of the last reply */
+} PCA9685Client_t;
+
+
+/* Functions declarations */
+
+/**
+ * \brief This function connects to the pca9685d daemon.
+ * \param [out] client -- Pointer to the connection.
+ * \param [in] socketPath -- Daemon socket path, NULL for PCA9685_PROTO_SOCKET_PATH.
+ * \returns PCA9685LIB_SUCCESS if the connection is successfully opened, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ClientConnect(PCA9685Client_t *client, const char *socketPath);
+
+/**
+ * \brief This function sends the masked channels of a frame to a board. The
+ *        daemon writes them on its next tick.
+ * \param [in] client -- Pointer to the connection.
+ * \param [in] i2cDevNumber -- Linux I2C dev number of the board bus.
+ * \param [in] i2cAddress -- I2C slave address of the board.
+ * \param [in] frame -- Pointer to the frame.
+ * \returns PCA9685LIB_SUCCESS if the daemon accepts the channels, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ClientSet(PCA9685Client_t *client, uint16_t i2cDevNumber, uint8_t i2cAddress, 
+                            const PCA9685Frame_t *frame);
+
+/**
+ * \brief This function gets the last values written by the daemon to a board.
+ * \param [in] client -- Pointer to the connection.
+ * \param [in] i2cDevNumber -- Linux I2C dev number of the board bus.
+ * \param [in] i2cAddress -- I2C slave address of the board.
+ * \param [in,out] frame -- Pointer to the frame. The mask selects the channels
+ *                         on input and holds the channels known to the daemon
+ *                         on output.
+ * \returns PCA9685LIB_SUCCESS if the values are successfully got, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ClientGet(PCA9685Client_t *client, uint16_t i2cDevNumber, uint8_t i2cAddress, 
+                            PCA9685Frame_t *frame);
+
+/**
+ * \brief This function subscribes the connection to the changes of some channels
+ *        of a board, replacing its previous subscription to the board.
+ * \param [in] client -- Pointer to the connection.
+ * \param [in] i2cDevNumber -- Linux I2C dev number of the board bus.
+ * \param [in] i2cAddress -- I2C slave address of the board.
+ * \param [in] channelMask -- Channels to watch, zero to unsubscribe.
+ * \returns PCA9685LIB_SUCCESS if the subscription is successfully set, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ClientSubscribe(PCA9685Client_t *client, uint16_t i2cDevNumber, 
+                                uint8_t i2cAddress, uint16_t channelMask);
+
+/**
+ * \brief This function runs safety actions on a board, or on every board with
+ *        PCA9685_PROTO_ALL_BOARDS, ahead of any pending channel. The boards
+ *        refuse new channels until PCA9685_ClientResume.
+ * \param [in] client -- Pointer to the connection.
+ * \param [in] i2cDevNumber -- Linux I2C dev number of the board bus.
+ * \param [in] i2cAddress -- I2C slave address of the board, or PCA9685_PROTO_ALL_BOARDS.
+ * \param [in] actions -- Bitmask of PCA9685_SAFETY_* actions.
+ * \returns PCA9685LIB_SUCCESS if the actions are successfully run, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ClientSafetyStop(PCA9685Client_t *client, uint16_t i2cDevNumber, 
+                                    uint8_t i2cAddress, uint8_t actions);
+
+/**
+ * \brief This function lets a board, or every board with PCA9685_PROTO_ALL_BOARDS,
+ *        accept channels again after a safety stop.
+ * \param [in] client -- Pointer to the connection.
+ * \param [in] i2cDevNumber -- Linux I2C dev number of the board bus.
+ * \param [in] i2cAddress -- I2C slave address of the board, or PCA9685_PROTO_ALL_BOARDS.
+ * \returns PCA9685LIB_SUCCESS if the boards are successfully resumed, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ClientResume(PCA9685Client_t *client, uint16_t i2cDevNumber, uint8_t i2cAddress);
+
+/**
+ * \brief This function waits for the next change notification.
+ * \param [in] client -- Pointer to the connection.
+ * \param [out] i2cDevNumber -- Linux I2C dev number of the board bus.
+ * \param [out] i2cAddress -- I2C slave address of the board.
+ * \param [out] frame -- Pointer to the frame receiving the changed channels.
+ * \param [in] timeoutMs -- Timeout in milliseconds, negative to wait forever.
+ * \returns PCA9685LIB_SUCCESS if a notification is received, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ClientWaitNotify(PCA9685Client_t *client, uint16_t *i2cDevNumber, 
+                                    uint8_t *i2cAddress, PCA9685Frame_t *frame, int timeoutMs);
+
+/**
+ * \brief This function closes a connection to the daemon.
+ * \param [in] client -- Pointer to the connection.
+ * \returns PCA9685LIB_SUCCESS if the connection is successfully closed, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ClientClose(PCA9685Client_t *client);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCA9685CLIENT_H
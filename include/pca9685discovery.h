@@ -0,0 +1,97 @@
+/*
+MIT License
+
+Copyright (c) 2024 Giuseppe Giglio <g.giglio001@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * \file pca9685discovery.h
+ * \brief This file contains the declarations of the discovery functions, which
+ *       probe every local I2C adapter in parallel for PCA9685 controllers.
+ *
+ * Each bus is probed by its own thread, one MODE1 read per candidate address.
+ * The ALLCALL and sub-addresses the PCA9685 answers to at power-on (0x70, 0x71,
+ * 0x72, 0x74) and the reserved addresses 0x78 to 0x7F are skipped, so that a
+ * board is never reported twice nor under a group address. A responding address
+ * is reported if its PRE_SCALE register also reads back at least
+ * PCA9685_MIN_PRESCALER, which the PCA9685 enforces.
+ */
+
+#ifndef PCA9685DISCOVERY_H
+#define PCA9685DISCOVERY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Standard library includes */
+#include <stdint.h>
+
+/* Local includes */
+#include "pca9685lib.h"
+
+/* Macros */
+
+#define PCA9685_DISCOVERY_MAX_BUSES (32U)
+#define PCA9685_DISCOVERY_FIRST_ADDR ((uint8_t) 0x40U)
+#define PCA9685_DISCOVERY_LAST_ADDR ((uint8_t) 0x77U)
+#define PCA9685_DISCOVERY_DEV_PATTERN "/dev/i2c-*"
+
+
+/* Typedefs */
+
+/**
+ * \struct PCA9685Device_t "pca9685discovery.h" pca9685discovery.h
+ * \brief This structure describes a discovered controller.
+*/
+typedef struct PCA9685Device_s
+{
+    uint16_t i2cDevNumber; /** Linux I2C dev number of the bus */
+    uint8_t i2cAddress; /** I2C slave address */
+    uint8_t mode1; /** MODE1 value read while probing */
+    uint8_t prescaler; /** PRE_SCALE value read while probing */
+} PCA9685Device_t;
+
+
+/* Functions declarations */
+
+/**
+ * \brief This function probes I2C buses in parallel for PCA9685 controllers.
+ *        Devices are reported sorted by bus, in the order of the bus list, then
+ *        by address. Buses that cannot be opened are skipped.
+ * \param [in] i2cDevNumbers -- Linux I2C dev numbers of the buses to probe, NULL
+ *             to probe every adapter matching PCA9685_DISCOVERY_DEV_PATTERN.
+ * \param [in] busCount -- Number of entries of i2cDevNumbers, ignored if it is NULL.
+ * \param [out] devices -- Device table.
+ * \param [in] maxDevices -- Number of entries of the device table.
+ * \param [out] deviceCount -- Number of devices found, possibly more than maxDevices.
+ * \returns PCA9685LIB_SUCCESS if the buses are successfully probed, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_Discover(const uint16_t *i2cDevNumbers, uint32_t busCount, 
+                            PCA9685Device_t *devices, uint32_t maxDevices, 
+                            uint32_t *deviceCount);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCA9685DISCOVERY_H
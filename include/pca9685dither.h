@@ -0,0 +1,115 @@
+/*
+MIT License
+
+Copyright (c) 2024 Giuseppe Giglio <g.giglio001@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * \file pca9685dither.h
+ * \brief This file contains the declarations of the temporal dithering stage
+ *       that gives PCA9685 channels more than 12 bits of effective resolution.
+ */
+
+#ifndef PCA9685DITHER_H
+#define PCA9685DITHER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Standard library includes */
+#include <stdint.h>
+
+/* Local includes */
+#include "pca9685lib.h"
+
+/* Macros */
+
+/* Extra resolution bits, on top of the 12 bits of the controller */
+#define PCA9685_DITHER_MIN_FRAC_BITS (1U)
+#define PCA9685_DITHER_MAX_FRAC_BITS (4U)
+
+
+/* Typedefs */
+
+/**
+ * \struct PCA9685Dither_t "pca9685dither.h" pca9685dither.h
+ * \brief This structure holds the dithering state of a board. Levels are duty
+ *        cycles scaled by 2^fracBits, from 0 to PCA9685_MAX_PWM_VALUE << fracBits.
+*/
+typedef struct PCA9685Dither_s
+{
+    PCA9685I2CConf_t *board; /** Board driven by the dithering stage */
+    uint8_t fracBits; /** Extra resolution bits */
+    uint16_t activeMask; /** Channels driven by the dithering stage */
+    uint32_t level[PCA9685_MAX_PWM_CHANNELS]; /** Requested levels */
+    uint32_t residual[PCA9685_MAX_PWM_CHANNELS]; /** Sigma-delta accumulators */
+    uint16_t output[PCA9685_MAX_PWM_CHANNELS]; /** Last duty cycles put in the frame */
+    PCA9685Frame_t frame; /** Frame committed at each tick */
+} PCA9685Dither_t;
+
+
+/* Functions declarations */
+
+/**
+ * \brief This function initializes the dithering stage of a board.
+ * \param [out] dither -- Pointer to the dithering state.
+ * \param [in] board -- Pointer to the board configuration data structure.
+ * \param [in] fracBits -- Extra resolution bits, from PCA9685_DITHER_MIN_FRAC_BITS
+ *        to PCA9685_DITHER_MAX_FRAC_BITS.
+ * \returns PCA9685LIB_SUCCESS if the dithering stage is successfully initialized, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_DitherInit(PCA9685Dither_t *dither, PCA9685I2CConf_t *board, uint8_t fracBits);
+
+/**
+ * \brief This function sets the level of a channel and hands the channel over to
+ *        the dithering stage.
+ * \param [in] dither -- Pointer to the dithering state.
+ * \param [in] channel -- PWM channel number.
+ * \param [in] level -- Level, from 0 to PCA9685_MAX_PWM_VALUE << fracBits.
+ * \returns PCA9685LIB_SUCCESS if the level is successfully set, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_DitherSetLevel(PCA9685Dither_t *dither, uint8_t channel, uint32_t level);
+
+/**
+ * \brief This function hands a channel back to the application.
+ * \param [in] dither -- Pointer to the dithering state.
+ * \param [in] channel -- PWM channel number.
+ * \returns PCA9685LIB_SUCCESS if the channel is successfully released, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_DitherRelease(PCA9685Dither_t *dither, uint8_t channel);
+
+/**
+ * \brief This function runs one refresh tick of the dithering stage. Each channel
+ *        alternates between the two 12-bit counts around its level so that their
+ *        average over 2^fracBits ticks matches it. Only channels whose count
+ *        changes are committed.
+ * \param [in] dither -- Pointer to the dithering state.
+ * \returns PCA9685LIB_SUCCESS if the tick is successfully committed, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_DitherTick(PCA9685Dither_t *dither);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCA9685DITHER_H
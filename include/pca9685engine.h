@@ -0,0 +1,191 @@
+/*
+MIT License
+
+Copyright (c) 2024 Giuseppe Giglio <g.giglio001@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * \file pca9685engine.h
+ * \brief This file contains the declarations of the multi-bus engine, which
+ *       runs one worker thread per I2C bus so that frames staged for boards on
+ *       different buses are committed in parallel.
+ *
+ * Commands have two priority classes. Staged frames are bulk traffic, written
+ * on the next commit. Safety actions (PCA9685_EngineSafetyStop) drop the staged
+ * frames and are run by every worker as soon as it is done with the board it
+ * is committing, without waiting for a commit. The worst-case latency of a
+ * safety action on a bus is therefore the commit of one board frame plus the
+ * safety transactions of the boards of the bus.
+ */
+
+#ifndef PCA9685ENGINE_H
+#define PCA9685ENGINE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Standard library includes */
+#include <pthread.h>
+#include <stdint.h>
+
+/* Local includes */
+#include "pca9685lib.h"
+
+/* Macros */
+
+#define PCA9685_ENGINE_MAX_BUSES (8U)
+#define PCA9685_ENGINE_MAX_BOARDS (16U) /** Boards per bus */
+
+#define PCA9685_ENGINE_NO_CPU (-1) /** Worker not pinned to a CPU */
+
+
+/* Typedefs */
+
+/**
+ * \struct PCA9685EngineBus_t "pca9685engine.h" pca9685engine.h
+ * \brief This structure holds a bus of the engine and its worker.
+*/
+typedef struct PCA9685EngineBus_s
+{
+    struct PCA9685Engine_s *engine; /** Engine of the bus */
+    uint16_t i2cDevNumber; /** Linux I2C dev number of the bus */
+    int cpu; /** CPU the worker is pinned to, PCA9685_ENGINE_NO_CPU if none */
+    pthread_t worker; /** Worker thread */
+    PCA9685I2CConf_t *boards[PCA9685_ENGINE_MAX_BOARDS]; /** Boards of the bus */
+    PCA9685Frame_t staged[PCA9685_ENGINE_MAX_BOARDS]; /** Frames staged for the next commit */
+    uint32_t boardCount; /** Number of boards */
+    uint32_t completed; /** Last commit generation flushed by the worker */
+    int16_t status; /** Status of the last flush */
+    uint8_t safety; /** PCA9685_SAFETY_* actions waiting for the worker */
+    uint32_t safetyCompleted; /** Last safety generation run by the worker */
+    int16_t safetyStatus; /** Status of the last safety actions */
+} PCA9685EngineBus_t;
+
+/**
+ * \struct PCA9685Engine_t "pca9685engine.h" pca9685engine.h
+ * \brief This structure holds the state of the multi-bus engine.
+*/
+typedef struct PCA9685Engine_s
+{
+    pthread_mutex_t mutex; /** Guards the staged frames and generations */
+    pthread_cond_t work; /** Signaled when a commit is requested */
+    pthread_cond_t done; /** Signaled when a worker completes a commit */
+    PCA9685EngineBus_t buses[PCA9685_ENGINE_MAX_BUSES]; /** Engine buses */
+    uint32_t busCount; /** Number of buses */
+    uint32_t generation; /** Last commit generation requested */
+    uint32_t safetyGeneration; /** Last safety generation requested */
+    uint8_t stopped; /** Non-zero after a safety stop, until PCA9685_EngineResume */
+    uint8_t running; /** Non-zero while the workers run */
+} PCA9685Engine_t;
+
+
+/* Functions declarations */
+
+/**
+ * \brief This function initializes an engine with no buses.
+ * \param [out] engine -- Pointer to the engine.
+ * \returns PCA9685LIB_SUCCESS if the engine is successfully initialized, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_EngineInit(PCA9685Engine_t *engine);
+
+/**
+ * \brief This function adds a bus to a stopped engine.
+ * \param [in] engine -- Pointer to the engine.
+ * \param [in] i2cDevNumber -- Linux I2C dev number of the bus.
+ * \param [in] cpu -- CPU to pin the bus worker to, PCA9685_ENGINE_NO_CPU to leave it unpinned.
+ * \returns PCA9685LIB_SUCCESS if the bus is successfully added, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_EngineAddBus(PCA9685Engine_t *engine, uint16_t i2cDevNumber, int cpu);
+
+/**
+ * \brief This function adds a board to a stopped engine. Its bus must have been
+ *        added first. The board is only used by the bus worker while the engine
+ *        runs.
+ * \param [in] engine -- Pointer to the engine.
+ * \param [in] board -- Pointer to the board configuration data structure.
+ * \returns PCA9685LIB_SUCCESS if the board is successfully added, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_EngineAddBoard(PCA9685Engine_t *engine, PCA9685I2CConf_t *board);
+
+/**
+ * \brief This function starts the bus workers.
+ * \param [in] engine -- Pointer to the engine.
+ * \returns PCA9685LIB_SUCCESS if the workers are successfully started, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_EngineStart(PCA9685Engine_t *engine);
+
+/**
+ * \brief This function stages the masked channels of a frame for a board. They
+ *        are merged with the channels already staged and written by the next
+ *        PCA9685_EngineCommitAll.
+ * \param [in] engine -- Pointer to the engine.
+ * \param [in] board -- Pointer to the board configuration data structure.
+ * \param [in] frame -- Pointer to the frame.
+ * \returns PCA9685LIB_SUCCESS if the frame is successfully staged, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_EngineStage(PCA9685Engine_t *engine, PCA9685I2CConf_t *board, 
+                            const PCA9685Frame_t *frame);
+
+/**
+ * \brief This function commits the staged frames of every board, each bus worker
+ *        flushing its boards in parallel, and returns once all buses are flushed.
+ *        Quarantined boards (see PCA9685_IsQuarantined) are skipped, and their frames,
+ *        like those that fail, stay staged for the next commit.
+ * \param [in] engine -- Pointer to the engine.
+ * \returns PCA9685LIB_SUCCESS if every board is successfully committed, otherwise PCA9685LIB_ERROR,
+ *          also when a safety stop cut the commit short.
+*/
+int16_t PCA9685_EngineCommitAll(PCA9685Engine_t *engine);
+
+/**
+ * \brief This function runs safety actions on every board of the engine ahead of
+ *        the bulk traffic. Staged frames are dropped, a commit in progress is cut
+ *        short after the board being written, and no frame can be staged until
+ *        PCA9685_EngineResume is called. Returns once every bus has run the actions.
+ * \param [in] engine -- Pointer to the engine.
+ * \param [in] actions -- Bitmask of PCA9685_SAFETY_* actions.
+ * \returns PCA9685LIB_SUCCESS if every board runs the actions successfully, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_EngineSafetyStop(PCA9685Engine_t *engine, uint8_t actions);
+
+/**
+ * \brief This function accepts staged frames again after a safety stop. Boards put
+ *        to sleep or with outputs disabled are left as they are.
+ * \param [in] engine -- Pointer to the engine.
+ * \returns PCA9685LIB_SUCCESS if the engine is successfully resumed, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_EngineResume(PCA9685Engine_t *engine);
+
+/**
+ * \brief This function stops and joins the bus workers. Staged frames not
+ *        committed yet are dropped.
+ * \param [in] engine -- Pointer to the engine.
+ * \returns PCA9685LIB_SUCCESS if the workers are successfully stopped, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_EngineStop(PCA9685Engine_t *engine);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCA9685ENGINE_H
@@ -129,9 +129,61 @@ extern "C" {
 /* Misc Defines */
 #define PCA9685_MAX_PWM_VALUE ((uint16_t) 4096U)
 #define PCA9685_MAX_PWM_CHANNELS ((uint8_t) 16U)
+#define PCA9685_LED_REGS_SIZE ((uint8_t) (PCA9685_MAX_PWM_CHANNELS * 4U))
 #define PCA9685_MAX_PRESCALER ((uint8_t) 0xFFU)
 #define PCA9685_MIN_PRESCALER ((uint8_t) 0x03U)
+#define PCA9685_DEFAULT_PRESCALER ((uint8_t) 0x1EU) /** Power-on value, 200 Hz */
 #define PCA9685_INT_CLOCK_FREQ ((uint32_t) 25000000U)
+#define PCA9685_OSC_STARTUP_US ((uint32_t) 500U) /** Oscillator start-up time after SLEEP is cleared */
+
+/* Power-on register values */
+#define PCA9685_MODE1_DEFAULT ((uint8_t) 0x11U) /** Sleeping, ALLCALL enabled, AI cleared */
+#define PCA9685_MODE2_DEFAULT ((uint8_t) 0x04U) /** Totem pole outputs */
+#define PCA9685_SUBADDR1_DEFAULT ((uint8_t) 0xE2U)
+#define PCA9685_SUBADDR2_DEFAULT ((uint8_t) 0xE4U)
+#define PCA9685_SUBADDR3_DEFAULT ((uint8_t) 0xE8U)
+#define PCA9685_ALLCALL_ADDR_DEFAULT ((uint8_t) 0xE0U)
+
+/* Default bus cost model, 100 kHz standard mode */
+#define PCA9685_DEFAULT_TRANSACTION_NS ((uint32_t) 150000U)
+#define PCA9685_DEFAULT_BYTE_NS ((uint32_t) 90000U)
+
+/* Bus cost calibration */
+#define PCA9685_COST_FORGET_FACTOR (0.98) /** Weight kept by past samples at each new one */
+#define PCA9685_COST_MIN_SAMPLES ((uint32_t) 16U) /** Samples needed before the model is updated */
+#define PCA9685_COST_OUTLIER_RATIO ((uint32_t) 8U) /** Samples slower than this times the model are dropped */
+
+/* Bus error classes, see PCA9685Error_t */
+#define PCA9685_ERR_NONE ((int16_t) 0)
+#define PCA9685_ERR_NO_ACK ((int16_t) 1) /** Device did not answer: ENXIO, EREMOTEIO, ENODEV */
+#define PCA9685_ERR_ARBITRATION ((int16_t) 2) /** Arbitration lost to another master: EAGAIN */
+#define PCA9685_ERR_BUS_BUSY ((int16_t) 3) /** Bus busy for too long: EBUSY */
+#define PCA9685_ERR_TIMEOUT ((int16_t) 4) /** Transfer timed out: ETIMEDOUT */
+#define PCA9685_ERR_PROTOCOL ((int16_t) 5) /** Transfer corrupted or aborted: EIO, EPROTO, EBADMSG */
+#define PCA9685_ERR_ADAPTER ((int16_t) 6) /** Adapter or descriptor unusable, any other errno */
+
+/* Bus operations, see PCA9685Error_t */
+#define PCA9685_OP_WRITE ((uint8_t) 1U)
+#define PCA9685_OP_READ ((uint8_t) 2U)
+
+/** Error classes worth retrying, as a bitmask of (1 << class) */
+#define PCA9685_ERR_TRANSIENT_MASK ((uint16_t) ((1U << PCA9685_ERR_ARBITRATION) | (1U << PCA9685_ERR_BUS_BUSY) \
+                                        | (1U << PCA9685_ERR_TIMEOUT) | (1U << PCA9685_ERR_PROTOCOL)))
+
+/* Device health, see PCA9685Health_t */
+#define PCA9685_HEALTH_FAIL_THRESHOLD ((uint32_t) 3U) /** Consecutive failures before quarantine */
+#define PCA9685_HEALTH_MIN_BACKOFF_MS ((uint32_t) 10U) /** First quarantine length */
+#define PCA9685_HEALTH_MAX_BACKOFF_MS ((uint32_t) 5000U) /** Longest quarantine length */
+
+/* Safety actions, run in this order by PCA9685_SafetyStop */
+#define PCA9685_SAFETY_ALL_OFF ((uint8_t) 0x01U) /** Every channel full OFF */
+#define PCA9685_SAFETY_DISABLE_OUTPUT ((uint8_t) 0x02U) /** MODE2 OUTNE set, as PCA9685_DisableOutput */
+#define PCA9685_SAFETY_SLEEP ((uint8_t) 0x04U) /** Oscillator stopped, as PCA9685_Sleep */
+
+/* modeShadowValid bits */
+#define PCA9685_MODE1_SHADOW_VALID ((uint8_t) 0x01U)
+#define PCA9685_MODE2_SHADOW_VALID ((uint8_t) 0x02U)
+#define PCA9685_PRESCALER_SHADOW_VALID ((uint8_t) 0x04U)
 
 
 #define COMPUTE_PRESCALER_VALUE(frequency) \
@@ -140,6 +192,121 @@ extern "C" {
 
 /* Typedefs */
 
+/**
+ * \struct PCA9685Frame_t "pca9685lib.h" pca9685lib.h
+ * \brief This structure holds the ON and OFF values of a whole board.
+ *        Only channels flagged in channelMask are updated on commit.
+*/
+typedef struct PCA9685Frame_s
+{
+    uint16_t onValue[PCA9685_MAX_PWM_CHANNELS]; /** ON values */
+    uint16_t offValue[PCA9685_MAX_PWM_CHANNELS]; /** OFF values */
+    uint16_t channelMask; /** Bitmask of channels to update */
+} PCA9685Frame_t;
+
+/**
+ * \struct PCA9685Profile_t "pca9685lib.h" pca9685lib.h
+ * \brief This structure holds a complete board configuration, applied at once
+ *        by PCA9685_InitWithProfile.
+*/
+typedef struct PCA9685Profile_s
+{
+    uint8_t mode1; /** MODE1 value, AI is always set and RESTART ignored */
+    uint8_t mode2; /** MODE2 value */
+    uint8_t prescaler; /** Prescaler value, see COMPUTE_PRESCALER_VALUE, zero for PCA9685_DEFAULT_PRESCALER */
+    PCA9685Frame_t outputs; /** Initial outputs, channels outside channelMask start full OFF */
+} PCA9685Profile_t;
+
+/**
+ * \struct PCA9685BusCost_t "pca9685lib.h" pca9685lib.h
+ * \brief This structure holds the bus cost model used to plan register writes.
+ *        A transaction of n bytes is assumed to cost transactionNs + n * byteNs.
+*/
+typedef struct PCA9685BusCost_s
+{
+    uint32_t transactionNs; /** Fixed cost of a transaction (start, address, stop, syscall) */
+    uint32_t byteNs; /** Cost of each byte on the wire */
+} PCA9685BusCost_t;
+
+/**
+ * \struct PCA9685CostEstimator_t "pca9685lib.h" pca9685lib.h
+ * \brief This structure holds the running sums of an exponentially weighted
+ *        linear regression of transaction time against transaction length.
+*/
+typedef struct PCA9685CostEstimator_s
+{
+    double sumW; /** Sum of sample weights */
+    double sumX; /** Weighted sum of lengths */
+    double sumY; /** Weighted sum of times */
+    double sumXX; /** Weighted sum of squared lengths */
+    double sumXY; /** Weighted sum of length-time products */
+    uint32_t samples; /** Number of samples taken */
+    PCA9685BusCost_t busCost; /** Last cost model fitted from the samples */
+    uint8_t fitted; /** Non-zero once busCost has been fitted */
+} PCA9685CostEstimator_t;
+
+/**
+ * \struct PCA9685LockStats_t "pca9685lib.h" pca9685lib.h
+ * \brief This structure holds the contention statistics of a bus lock.
+*/
+typedef struct PCA9685LockStats_s
+{
+    uint64_t acquisitions; /** Number of times the lock was taken */
+    uint64_t contended; /** Number of times the lock was held by another thread */
+    uint64_t waitNs; /** Total time spent waiting for the lock, in nanoseconds */
+    uint64_t maxWaitNs; /** Longest wait for the lock, in nanoseconds */
+    uint64_t holdNs; /** Total time the lock was held, in nanoseconds */
+} PCA9685LockStats_t;
+
+/**
+ * \struct PCA9685Health_t "pca9685lib.h" pca9685lib.h
+ * \brief This structure holds the health of a controller. After
+ *        PCA9685_HEALTH_FAIL_THRESHOLD consecutive failed transactions the
+ *        controller is quarantined, and batched flushes skip it until retryAtNs.
+ *        Each failed retry doubles the quarantine, up to PCA9685_HEALTH_MAX_BACKOFF_MS,
+ *        and any successful transaction clears it.
+*/
+typedef struct PCA9685Health_s
+{
+    uint32_t consecutiveFailures; /** Failed transactions since the last success */
+    uint32_t backoffMs; /** Current quarantine length, zero while healthy */
+    uint64_t retryAtNs; /** Monotonic time after which a quarantined controller is tried again */
+    uint64_t failures; /** Failed transactions */
+    uint64_t quarantines; /** Times the controller was quarantined */
+} PCA9685Health_t;
+
+/**
+ * \struct PCA9685Error_t "pca9685lib.h" pca9685lib.h
+ * \brief This structure describes the last failed bus transaction of a handle.
+*/
+typedef struct PCA9685Error_s
+{
+    int16_t code; /** PCA9685_ERR_* class of the error */
+    uint8_t op; /** PCA9685_OP_* operation */
+    uint8_t reg; /** First register of the transaction */
+    uint8_t length; /** Number of bytes of the transaction */
+    uint8_t attempts; /** Attempts made, retries included */
+    int errnum; /** errno reported by the I2C library */
+} PCA9685Error_t;
+
+/**
+ * \struct PCA9685RetryPolicy_t "pca9685lib.h" pca9685lib.h
+ * \brief This structure holds the retry policy of a handle. A failed transaction
+ *        is retried only if its error class is flagged in retryMask.
+*/
+typedef struct PCA9685RetryPolicy_s
+{
+    uint8_t maxRetries; /** Retries after the first attempt, zero to never retry */
+    uint32_t delayUs; /** Delay before each retry, in microseconds */
+    uint16_t retryMask; /** Error classes to retry, as a bitmask of (1 << class) */
+} PCA9685RetryPolicy_t;
+
+/** Lock shared by the thread-safe handles of a bus, opaque */
+typedef struct PCA9685BusLock_s PCA9685BusLock_t;
+
+/** Cost estimator shared by the handles of a bus, opaque */
+typedef struct PCA9685BusEstimator_s PCA9685BusEstimator_t;
+
 /**
  * \struct PCA9685I2CConf_t "pca9685lib.h" pca9685lib.h
  * \brief This structure contains the configuration parameters 
@@ -149,22 +316,45 @@ typedef struct PCA9685I2CConf_s
 {
     i2cConfiguration_t i2cConf; /** I2C configuration parameters */
     uint8_t i2cAddr; /** I2C address of the PCA9685 controller */
+    uint16_t i2cDevNumber; /** Linux I2C dev number of the bus */
+    PCA9685BusLock_t *busLock; /** Bus lock, NULL unless thread-safe mode is enabled */
+    uint8_t autoIncrement; /** Non-zero once MODE1 AI bit is known to be set */
+    uint8_t prescaler; /** Last prescaler value written or read, see PCA9685_PRESCALER_SHADOW_VALID */
+    uint8_t mode1Shadow; /** Last value written to MODE1, RESTART bit cleared */
+    uint8_t mode2Shadow; /** Last value written to MODE2 */
+    uint8_t modeShadowValid; /** Bit 0 set once mode1Shadow is known, bit 1 for mode2Shadow, bit 2 for prescaler */
+    uint32_t shadowSeq; /** Sequence lock of ledShadow and shadowValid, odd while they change */
+    uint16_t shadowValid; /** Bitmask of channels whose shadow copy matches the device */
+    uint8_t ledShadow[PCA9685_LED_REGS_SIZE]; /** Last values written to the LEDn registers */
+    PCA9685BusCost_t busCost; /** Bus cost model used to plan writes */
+    PCA9685BusEstimator_t *costEstimator; /** Live calibration of busCost, shared by the handles of the bus */
+    uint8_t costCalibration; /** Non-zero if live measurements update busCost */
+    uint16_t slewLimit[PCA9685_MAX_PWM_CHANNELS]; /** Maximum duty cycle change per commit */
+    PCA9685Frame_t slewTarget; /** Targets not reached yet because of slewLimit */
+    uint8_t slewEnabled; /** Non-zero if any channel is slew-rate limited */
+    PCA9685Health_t health; /** Transaction health */
+    PCA9685Error_t lastError; /** Last failed bus transaction */
+    PCA9685RetryPolicy_t retryPolicy; /** Retry policy of failed transactions */
+    uint32_t autoSleepMs; /** Idle time before an all-off controller is put to sleep, zero to disable */
+    uint64_t lastWriteNs; /** Monotonic time of the last LEDn registers write */
+    uint8_t autoSlept; /** Non-zero while the controller sleeps because of auto-sleep */
 } PCA9685I2CConf_t;
 
 /**
  * \struct PCA9685ModeReg_t "pca9685lib.h" pca9685lib.h
  * \brief This structure holds MODE1 register bitfield.
+ *        Fields are listed from the least significant bit, as laid out by GCC.
 */
 typedef struct PCA9685Mode1Reg_s
 {
-    uint8_t restart : 1; /** Restart bit */
-    uint8_t extclk : 1; /** External clock bit */
-    uint8_t ai : 1; /** Auto increment bit */
-    uint8_t sleep : 1; /** Sleep bit */
-    uint8_t sub1 : 1; /** Subaddress 1 bit */
-    uint8_t sub2 : 1; /** Subaddress 2 bit */
+    uint8_t allcall : 1; /** All call bit (bit 0) */
     uint8_t sub3 : 1; /** Subaddress 3 bit */
-    uint8_t allcall : 1; /** All call bit */
+    uint8_t sub2 : 1; /** Subaddress 2 bit */
+    uint8_t sub1 : 1; /** Subaddress 1 bit */
+    uint8_t sleep : 1; /** Sleep bit */
+    uint8_t ai : 1; /** Auto increment bit */
+    uint8_t extclk : 1; /** External clock bit */
+    uint8_t restart : 1; /** Restart bit (bit 7) */
 } PCA9685Mode1Reg_t;
 
 typedef union
@@ -176,14 +366,15 @@ typedef union
 /**
  * \struct PCA9685Mode2Reg_t "pca9685lib.h" pca9685lib.h
  * \brief This structure holds MODE2 register bitfield.
+ *        Fields are listed from the least significant bit, as laid out by GCC.
 */
 typedef struct PCA9685Mode2Reg_s
 {
-    uint8_t reserved : 3; /** Reserved bits */
-    uint8_t invrt : 1; /** Output logic state inversion bit */
-    uint8_t ocha : 1; /** Outputs change on ACK bit */
+    uint8_t outne : 2; /** Output not enabled bits (bits 1:0) */
     uint8_t outdrv : 1; /** Output driver bit */
-    uint8_t outne : 2; /** Output not enabled bits */
+    uint8_t ocha : 1; /** Outputs change on ACK bit */
+    uint8_t invrt : 1; /** Output logic state inversion bit */
+    uint8_t reserved : 3; /** Reserved bits (bits 7:5) */
 } PCA9685Mode2Reg_t;
 
 typedef union
@@ -197,7 +388,9 @@ typedef union
 
 /**
  * \brief This function initializes and verifies communication to
- *        the PCA9685 controller.
+ *        the PCA9685 controller. The handle is considered uninitialized: an
+ *        open handle, thread-safe or not, must be closed with PCA9685_Close
+ *        before it is initialized again, or its bus references leak.
  * \param [in] controllerConf -- PCA9685 I2C configuration parameters.
  * \param [in] i2cAddress -- I2C slave address of the PCA9685 controller.
  * \param [in] i2cDevNumber -- Linux I2C dev number. (e.g: /dev/i2c-1, i2cDevNumber = 1)
@@ -207,6 +400,21 @@ typedef union
 int16_t PCA9685_Init(PCA9685I2CConf_t *controllerConf, uint8_t i2cAddress, 
                         uint16_t i2cDevNumber);
 
+/**
+ * \brief This function initializes the controller handle as PCA9685_Init, then
+ *        applies a complete configuration in three transactions: MODE1 with
+ *        SLEEP and AI, the prescaler, then one burst from MODE1 to LED15_OFF_H
+ *        holding the final MODE1, MODE2 and every LEDn register.
+ * \param [in] controllerConf -- PCA9685 I2C configuration parameters.
+ * \param [in] i2cAddress -- I2C slave address of the PCA9685 controller.
+ * \param [in] i2cDevNumber -- Linux I2C dev number. (e.g: /dev/i2c-1, i2cDevNumber = 1)
+ * \param [in] profile -- Configuration to apply.
+ * \returns PCA9685LIB_SUCCESS if the configuration is successfully applied, otherwise PCA9685LIB_ERROR
+ *          and the controller is closed.
+*/
+int16_t PCA9685_InitWithProfile(PCA9685I2CConf_t *controllerConf, uint8_t i2cAddress, 
+                                    uint16_t i2cDevNumber, const PCA9685Profile_t *profile);
+
 /**
  * \brief This function gets the MODE1 register value.
  * \param [in] controllerConf -- Pointer to the controller configuration data structure.
@@ -248,7 +456,9 @@ int16_t PCA9685_SetMode2Reg(PCA9685I2CConf_t *controllerConf, PCA9685Mode2Reg_u
 int16_t PCA9685_GetPrescaler(PCA9685I2CConf_t *controllerConf, uint8_t *prescaler);
 
 /**
- * \brief This function sets the prescaler value.
+ * \brief This function sets the prescaler value. The chip only takes it while
+ *        sleeping, so a running controller is put to sleep for the write and
+ *        resumed with PCA9685_FastResume. A sleeping controller is left asleep.
  * \param [in] controllerConf -- Pointer to the controller configuration data structure.
  * \param [in] prescaler -- Prescaler value.
  * \returns PCA9685LIB_SUCCESS if the prescaler value is successfully set, otherwise PCA9685LIB_ERROR.
@@ -268,6 +478,8 @@ int16_t PCA9685_GetPWM(PCA9685I2CConf_t *controllerConf, uint8_t channel,
 
 /**
  * \brief This function sets the ON and OFF values of a PWM channel.
+ *        If the cached ON value of the channel equals onValue, only the OFF
+ *        registers are written.
  * \param [in] controllerConf -- Pointer to the controller configuration data structure.
  * \param [in] channel -- PWM channel number.
  * \param [in] onValue -- ON value.
@@ -277,6 +489,54 @@ int16_t PCA9685_GetPWM(PCA9685I2CConf_t *controllerConf, uint8_t channel,
 int16_t PCA9685_SetPWM(PCA9685I2CConf_t *controllerConf, uint8_t channel, 
                         uint16_t onValue, uint16_t offValue);
 
+/**
+ * \brief This function sets only the OFF value of a PWM channel, leaving
+ *        the ON value untouched.
+ * \param [in] controllerConf -- Pointer to the controller configuration data structure.
+ * \param [in] channel -- PWM channel number.
+ * \param [in] offValue -- OFF value.
+ * \returns PCA9685LIB_SUCCESS if the OFF value is successfully set, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_SetPWMOff(PCA9685I2CConf_t *controllerConf, uint8_t channel, 
+                            uint16_t offValue);
+
+/**
+ * \brief This function gets the last ON and OFF values committed to a PWM channel
+ *        from the shadow copy, without any bus access. It may be called from
+ *        any thread while another thread writes to the controller.
+ * \param [in] controllerConf -- Pointer to the controller configuration data structure.
+ * \param [in] channel -- PWM channel number.
+ * \param [out] onValue -- Pointer to the ON value.
+ * \param [out] offValue -- Pointer to the OFF value.
+ * \returns PCA9685LIB_SUCCESS if the channel values are known, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_GetCachedPWM(const PCA9685I2CConf_t *controllerConf, uint8_t channel, 
+                                uint16_t *onValue, uint16_t *offValue);
+
+/**
+ * \brief This function gets a consistent snapshot of the last ON and OFF values
+ *        committed to all PWM channels, without any bus access. It may be called
+ *        from any thread while another thread writes to the controller.
+ * \param [in] controllerConf -- Pointer to the controller configuration data structure.
+ * \param [out] frame -- Pointer to the frame, whose mask flags the known channels. Values
+ *                      with the full ON or OFF bit set are reported as PCA9685_MAX_PWM_VALUE.
+ * \returns PCA9685LIB_SUCCESS if the snapshot is successfully taken, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_GetPWMSnapshot(const PCA9685I2CConf_t *controllerConf, PCA9685Frame_t *frame);
+
+/**
+ * \brief This function reads back the LEDn registers of some channels in one
+ *        burst, compares them with the shadow copy and rewrites the registers
+ *        that differ from it. Channels whose value is not known are skipped.
+ * \param [in] controllerConf -- Pointer to the controller configuration data structure.
+ * \param [in] channelMask -- Bitmask of channels to verify.
+ * \param [out] mismatched -- Bitmask of channels found different from the shadow copy.
+ * \returns PCA9685LIB_SUCCESS if the channels are successfully verified and repaired,
+ *          otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ScrubChannels(PCA9685I2CConf_t *controllerConf, uint16_t channelMask, 
+                                uint16_t *mismatched);
+
 
 /**
  * \brief This function gets the ON and OFF values of all PWM channels.
@@ -298,9 +558,160 @@ int16_t PCA9685_GetAllPWM(PCA9685I2CConf_t *controllerConf, uint16_t *onValue,
 int16_t PCA9685_SetAllPWM(PCA9685I2CConf_t *controllerConf, uint16_t onValue, 
                             uint16_t offValue);
 
+/**
+ * \brief This function commits a frame to the PCA9685 controller, writing only
+ *        registers that differ from the shadow copy. Dirty registers are grouped
+ *        into auto-increment spans according to the bus cost model: unchanged
+ *        registers between two spans are rewritten when that is cheaper than
+ *        starting a new transaction. When the resulting board state has every
+ *        channel set to the same ON/OFF pair and that is cheaper, a single
+ *        ALL_LED write is issued instead.
+ * \param [in] controllerConf -- Pointer to the controller configuration data structure.
+ * \param [in] frame -- Pointer to the frame to commit.
+ * \returns PCA9685LIB_SUCCESS if the frame is successfully committed, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_CommitFrame(PCA9685I2CConf_t *controllerConf, const PCA9685Frame_t *frame);
+
+/**
+ * \brief This function sets the maximum duty cycle change per commit of every
+ *        channel. Frames committed afterwards move each limited channel towards
+ *        its target by at most its limit; the remaining distance is covered by
+ *        PCA9685_SlewStep or by later commits, so targets may be sent at a lower
+ *        rate than the refresh rate. PCA9685_SetPWM, PCA9685_SetPWMOff and
+ *        PCA9685_SetAllPWM bypass the limiter and cancel the pending targets of
+ *        the channels they write.
+ * \param [in] controllerConf -- Pointer to the controller configuration data structure.
+ * \param [in] maxDelta -- PCA9685_MAX_PWM_CHANNELS limits, 0 for an unlimited channel,
+ *        or NULL to disable limiting.
+ * \returns PCA9685LIB_SUCCESS if the limits are successfully set, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_SetSlewLimits(PCA9685I2CConf_t *controllerConf, const uint16_t *maxDelta);
+
+/**
+ * \brief This function moves slew-rate limited channels one more step towards
+ *        their last committed targets.
+ * \param [in] controllerConf -- Pointer to the controller configuration data structure.
+ * \returns PCA9685LIB_SUCCESS if the step is successfully committed, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_SlewStep(PCA9685I2CConf_t *controllerConf);
+
+/**
+ * \brief This function stores a duty cycle for a channel of a frame and flags the
+ *        channel for update. A duty of 0 and of PCA9685_MAX_PWM_VALUE are encoded
+ *        with the full OFF and full ON bits respectively.
+ * \param [out] frame -- Pointer to the frame.
+ * \param [in] channel -- PWM channel number.
+ * \param [in] duty -- Duty cycle, from 0 to PCA9685_MAX_PWM_VALUE.
+ * \returns PCA9685LIB_SUCCESS if the duty cycle is successfully stored, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_FrameSetDuty(PCA9685Frame_t *frame, uint8_t channel, uint16_t duty);
+
+/**
+ * \brief This function copies the flagged channels of a frame into another frame
+ *        and flags them there, leaving its other channels untouched.
+ * \param [in,out] into -- Pointer to the frame merged into.
+ * \param [in] frame -- Pointer to the frame to merge.
+ * \returns PCA9685LIB_SUCCESS if the frame is successfully merged, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_FrameMerge(PCA9685Frame_t *into, const PCA9685Frame_t *frame);
+
+/**
+ * \brief This function converts a frame to the values of the LEDn registers of a
+ *        whole board. Channels outside the frame mask are set full OFF.
+ * \param [in] frame -- Pointer to the frame.
+ * \param [out] ledRegs -- Array of PCA9685_LED_REGS_SIZE register values.
+ * \returns PCA9685LIB_SUCCESS if the frame is successfully converted, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_FrameToRegs(const PCA9685Frame_t *frame, uint8_t *ledRegs);
+
+
+/**
+ * \brief This function sets the bus cost model used to plan register writes.
+ *        Live calibration replaces these values once enough transactions have been
+ *        measured; disable it with PCA9685_SetCostCalibration to keep them fixed.
+ * \param [in] controllerConf -- Pointer to the controller configuration data structure.
+ * \param [in] transactionNs -- Fixed cost of a transaction, in nanoseconds.
+ * \param [in] byteNs -- Cost of each byte on the wire, in nanoseconds.
+ * \returns PCA9685LIB_SUCCESS if the cost model is successfully set, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_SetBusCost(PCA9685I2CConf_t *controllerConf, uint32_t transactionNs, 
+                            uint32_t byteNs);
+
+/**
+ * \brief This function enables or disables live calibration of the bus cost model.
+ *        When enabled (the default after PCA9685_Init), the duration of every I2C
+ *        transaction is measured and busCost is refitted from the measurements.
+ *        The measurements of every handle of the same bus in the process feed a
+ *        single estimator, so all of them agree on the bus cost.
+ * \param [in] controllerConf -- Pointer to the controller configuration data structure.
+ * \param [in] enable -- Non-zero to enable calibration.
+ * \returns PCA9685LIB_SUCCESS if calibration is successfully configured, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_SetCostCalibration(PCA9685I2CConf_t *controllerConf, uint8_t enable);
+
+/**
+ * \brief This function runs safety actions on the controller with the fewest
+ *        transactions: all-off is a single write of the ALL_LED_OFF_H full OFF
+ *        bit. Pending slew-rate limited targets are dropped so that they do not
+ *        bring the channels back.
+ * \param [in] controllerConf -- Pointer to the controller configuration data structure.
+ * \param [in] actions -- Bitmask of PCA9685_SAFETY_* actions.
+ * \returns PCA9685LIB_SUCCESS if every action is successfully run, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_SafetyStop(PCA9685I2CConf_t *controllerConf, uint8_t actions);
+
+/**
+ * \brief This function writes prebuilt values to all the LEDn registers in a
+ *        single transaction, bypassing slew-rate limits and dropping pending
+ *        slew targets, then runs the PCA9685_SAFETY_DISABLE_OUTPUT and
+ *        PCA9685_SAFETY_SLEEP actions requested.
+ * \param [in] controllerConf -- Pointer to the controller configuration data structure.
+ * \param [in] ledRegs -- Array of PCA9685_LED_REGS_SIZE register values, see PCA9685_FrameToRegs.
+ * \param [in] actions -- Bitmask of PCA9685_SAFETY_* actions, PCA9685_SAFETY_ALL_OFF is ignored.
+ * \returns PCA9685LIB_SUCCESS if the values are written and the actions run successfully,
+ *          otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_WriteFailSafe(PCA9685I2CConf_t *controllerConf, const uint8_t *ledRegs, 
+                                uint8_t actions);
+
+/**
+ * \brief This function checks whether the controller has lost its state, e.g.
+ *        after a brown-out or a software reset on the bus. MODE1 is read back
+ *        and compared with the last value written; if MODE1 was never written,
+ *        the state is lost when MODE1 reads its power-on value although the
+ *        handle already relied on auto increment. While the state is good and
+ *        the prescaler is not known yet, PRE_SCALE is read back for a later restore.
+ * \param [in] controllerConf -- Pointer to the controller configuration data structure.
+ * \param [out] stateLost -- Set to non-zero if the state is lost, zero otherwise.
+ * \returns PCA9685LIB_SUCCESS if MODE1 is successfully read, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_CheckState(PCA9685I2CConf_t *controllerConf, uint8_t *stateLost);
+
+/**
+ * \brief This function restores MODE1, MODE2, the prescaler and all the LEDn
+ *        registers from the shadow copy in three transactions: MODE1 sleep with
+ *        auto increment, prescaler, then one burst from MODE1 to LED15_OFF_H.
+ *        Registers never written through the handle get their power-on value,
+ *        except the prescaler, which is only restored once written or read back
+ *        through the handle.
+ * \param [in] controllerConf -- Pointer to the controller configuration data structure.
+ * \returns PCA9685LIB_SUCCESS if the state is successfully restored, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_RestoreState(PCA9685I2CConf_t *controllerConf);
+
+/**
+ * \brief This function resumes the PWM channels after sleep without rewriting
+ *        the LEDn registers. If RESTART is pending, SLEEP is cleared, the
+ *        oscillator start-up time is waited for and RESTART is written; otherwise
+ *        SLEEP is only cleared. Nothing is written if the controller is running.
+ * \param [in] controllerConf -- Pointer to the controller configuration data structure.
+ * \returns PCA9685LIB_SUCCESS if the controller is successfully resumed, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_FastResume(PCA9685I2CConf_t *controllerConf);
 
 /**
- * \brief This function resets the PCA9685 controller.
+ * \brief This function restarts the PWM channels of the PCA9685 controller
+ *        after sleep, as PCA9685_FastResume.
  * \param [in] controllerConf -- Pointer to the controller configuration data structure.
  * \returns PCA9685LIB_SUCCESS if the controller is successfully reset, otherwise PCA9685LIB_ERROR.
 */
@@ -314,7 +725,8 @@ int16_t PCA9685_Reset(PCA9685I2CConf_t *controllerConf);
 int16_t PCA9685_Sleep(PCA9685I2CConf_t *controllerConf);
 
 /**
- * \brief This function wakes up the PCA9685 controller.
+ * \brief This function wakes up the PCA9685 controller. A pending RESTART is
+ *        left pending, PCA9685_FastResume restarts the channels instead.
  * \param [in] controllerConf -- Pointer to the controller configuration data structure.
  * \returns PCA9685LIB_SUCCESS if the controller is successfully woken up, otherwise PCA9685LIB_ERROR.
 */
@@ -343,7 +755,121 @@ int16_t PCA9685_DisableOutput(PCA9685I2CConf_t *controllerConf);
 int16_t PCA9685_SetOutputInversion(PCA9685I2CConf_t *controllerConf, uint8_t invrt);
 
 /**
- * \brief This function closes communication with the controller.
+ * \brief This function enables or disables the thread-safe mode of a handle.
+ *        Thread-safe handles of the same bus share a lock that serializes
+ *        their transactions and multi-step sequences, such as read-modify-write
+ *        of the MODE registers or frame commits. Must be called before the
+ *        handle is shared between threads.
+ * \param [in] controllerConf -- Pointer to the controller configuration data structure.
+ * \param [in] enable -- Non-zero to enable the thread-safe mode.
+ * \returns PCA9685LIB_SUCCESS if the mode is successfully changed, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_SetThreadSafe(PCA9685I2CConf_t *controllerConf, uint8_t enable);
+
+/**
+ * \brief This function gets the contention statistics of the bus lock of a
+ *        thread-safe handle. They are shared by all the handles of the bus.
+ * \param [in] controllerConf -- Pointer to the controller configuration data structure.
+ * \param [out] stats -- Pointer to the statistics.
+ * \returns PCA9685LIB_SUCCESS if the statistics are successfully got, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_GetLockStats(PCA9685I2CConf_t *controllerConf, PCA9685LockStats_t *stats);
+
+/**
+ * \brief This function clears the contention statistics of the bus lock of a
+ *        thread-safe handle.
+ * \param [in] controllerConf -- Pointer to the controller configuration data structure.
+ * \returns PCA9685LIB_SUCCESS if the statistics are successfully cleared, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ResetLockStats(PCA9685I2CConf_t *controllerConf);
+
+/**
+ * \brief This function sets the timeout and the number of retries of every
+ *        transaction on an I2C bus, through the I2C_TIMEOUT and I2C_RETRIES
+ *        ioctls. The setting belongs to the adapter and applies to every device
+ *        and process using the bus.
+ * \param [in] i2cDevNumber -- Linux I2C dev number. (e.g: /dev/i2c-1, i2cDevNumber = 1)
+ * \param [in] timeoutMs -- Transaction timeout, in milliseconds, rounded up to the 10 ms unit.
+ * \param [in] retries -- Number of retries of a transaction lost to arbitration.
+ * \returns PCA9685LIB_SUCCESS if the bus is successfully configured, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_SetBusTimeout(uint16_t i2cDevNumber, uint32_t timeoutMs, uint32_t retries);
+
+/**
+ * \brief This function gets the transaction health of the controller.
+ * \param [in] controllerConf -- Pointer to the controller configuration data structure.
+ * \param [out] health -- Pointer to the health.
+ * \returns PCA9685LIB_SUCCESS if the health is successfully got, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_GetHealth(const PCA9685I2CConf_t *controllerConf, PCA9685Health_t *health);
+
+/**
+ * \brief This function gets the last failed bus transaction of the handle. The
+ *        slot is overwritten by each failure and never cleared by a success, so
+ *        it is meant to be read right after a call returned PCA9685LIB_ERROR.
+ *        A code of PCA9685_ERR_NONE means no bus transaction failed, the error
+ *        then came from the arguments.
+ * \param [in] controllerConf -- Pointer to the controller configuration data structure.
+ * \param [out] error -- Pointer to the error.
+ * \returns PCA9685LIB_SUCCESS if the error is successfully got, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_GetLastError(const PCA9685I2CConf_t *controllerConf, PCA9685Error_t *error);
+
+/**
+ * \brief This function clears the last error slot of the handle.
+ * \param [in] controllerConf -- Pointer to the controller configuration data structure.
+ * \returns PCA9685LIB_SUCCESS if the slot is successfully cleared, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ClearLastError(PCA9685I2CConf_t *controllerConf);
+
+/**
+ * \brief This function sets the retry policy of the handle, applied to every bus
+ *        transaction. By default transactions are not retried.
+ * \param [in] controllerConf -- Pointer to the controller configuration data structure.
+ * \param [in] policy -- Pointer to the policy.
+ * \returns PCA9685LIB_SUCCESS if the policy is successfully set, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_SetRetryPolicy(PCA9685I2CConf_t *controllerConf, const PCA9685RetryPolicy_t *policy);
+
+/**
+ * \brief This function tells whether batched flushes must skip the controller,
+ *        because it is quarantined and its retry time has not come yet.
+ * \param [in] controllerConf -- Pointer to the controller configuration data structure.
+ * \returns Non-zero if the controller must be skipped, zero otherwise.
+*/
+uint8_t PCA9685_IsQuarantined(const PCA9685I2CConf_t *controllerConf);
+
+/**
+ * \brief This function sets the auto-sleep idle time of the controller. Once
+ *        every channel is off and no LEDn register was written for that time,
+ *        PCA9685_AutoSleepPoll puts the controller to sleep. The next write
+ *        turning a channel on wakes it up with PCA9685_FastResume first.
+ *        Sleeps requested with PCA9685_Sleep are never undone by writes.
+ * \param [in] controllerConf -- Pointer to the controller configuration data structure.
+ * \param [in] idleMs -- Idle time in milliseconds, zero to disable auto-sleep.
+ * \returns PCA9685LIB_SUCCESS if the idle time is successfully set, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_SetAutoSleep(PCA9685I2CConf_t *controllerConf, uint32_t idleMs);
+
+/**
+ * \brief This function puts the controller to sleep if auto-sleep is enabled,
+ *        every channel is known to be off and the idle time has elapsed.
+ *        Nothing is sent to the bus otherwise. Meant to be called periodically.
+ * \param [in] controllerConf -- Pointer to the controller configuration data structure.
+ * \returns PCA9685LIB_SUCCESS if the controller is successfully checked, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_AutoSleepPoll(PCA9685I2CConf_t *controllerConf);
+
+/**
+ * \brief This function tells whether the controller sleeps because of auto-sleep.
+ * \param [in] controllerConf -- Pointer to the controller configuration data structure.
+ * \returns Non-zero if the controller was put to sleep by PCA9685_AutoSleepPoll, zero otherwise.
+*/
+uint8_t PCA9685_IsAutoSlept(const PCA9685I2CConf_t *controllerConf);
+
+/**
+ * \brief This function closes communication with the controller. The bus
+ *        lock and bus estimator references are dropped even if closing fails.
  * \param [in] controllerConf -- Pointer to the controller configuration data structure.
  * \returns PCA9685LIB_SUCCESS if the communication is successfully closed, otherwise PCA9685LIB_ERROR.
 */
@@ -0,0 +1,151 @@
+/*
+MIT License
+
+Copyright (c) 2024 Giuseppe Giglio <g.giglio001@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * \file pca9685motion.h
+ * \brief This file contains the declarations of the motion layer that moves
+ *       PCA9685 channels towards target pulse widths along trapezoidal or
+ *       S-curve profiles.
+ */
+
+#ifndef PCA9685MOTION_H
+#define PCA9685MOTION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Standard library includes */
+#include <stdint.h>
+
+/* Local includes */
+#include "pca9685lib.h"
+
+/* Macros */
+
+/* Motion profiles */
+#define PCA9685_MOTION_TRAPEZOIDAL ((uint8_t) 0U) /** Velocity and acceleration limited */
+#define PCA9685_MOTION_SCURVE ((uint8_t) 1U) /** Velocity, acceleration and jerk limited */
+
+/* Longest moving average used to limit jerk, in ticks */
+#define PCA9685_MOTION_MAX_SMOOTH (32U)
+
+
+/* Typedefs */
+
+/**
+ * \struct PCA9685MotionAxis_t "pca9685motion.h" pca9685motion.h
+ * \brief This structure holds the motion state of a channel. Positions are
+ *        pulse widths in PWM counts, rates are expressed per tick.
+*/
+typedef struct PCA9685MotionAxis_s
+{
+    float target; /** Target position */
+    float refPosition; /** Trapezoidal reference position */
+    float refVelocity; /** Trapezoidal reference velocity */
+    float position; /** Output position */
+    float maxVelocity; /** Velocity limit, per tick */
+    float maxAcceleration; /** Acceleration limit, per tick squared */
+    float smoothRing[PCA9685_MOTION_MAX_SMOOTH]; /** Last reference velocities */
+    float smoothSum; /** Sum of smoothRing */
+    uint8_t smoothLength; /** Moving average length, 1 for trapezoidal profiles */
+    uint8_t smoothIndex; /** Oldest entry of smoothRing */
+    uint8_t settleTicks; /** Ticks spent with the reference at rest on the target */
+    uint16_t output; /** Last pulse width written to the frame */
+} PCA9685MotionAxis_t;
+
+/**
+ * \struct PCA9685Motion_t "pca9685motion.h" pca9685motion.h
+ * \brief This structure holds the motion state of a board.
+*/
+typedef struct PCA9685Motion_s
+{
+    PCA9685I2CConf_t *board; /** Board driven by the motion layer */
+    float tickHz; /** Tick rate */
+    PCA9685MotionAxis_t axes[PCA9685_MAX_PWM_CHANNELS]; /** Channel motion states */
+    PCA9685Frame_t frame; /** Frame committed at each tick */
+    uint16_t movingMask; /** Channels still moving */
+} PCA9685Motion_t;
+
+
+/* Functions declarations */
+
+/**
+ * \brief This function initializes the motion layer of a board. Channels start
+ *        at rest, with no limits, until configured.
+ * \param [out] motion -- Pointer to the motion state.
+ * \param [in] board -- Pointer to the board configuration data structure.
+ * \param [in] tickHz -- Rate at which PCA9685_MotionTick is called.
+ * \returns PCA9685LIB_SUCCESS if the motion layer is successfully initialized, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_MotionInit(PCA9685Motion_t *motion, PCA9685I2CConf_t *board, float tickHz);
+
+/**
+ * \brief This function sets the motion profile and limits of a channel.
+ *        S-curve profiles limit jerk by averaging the trapezoidal velocity over
+ *        maxAcceleration / maxJerk ticks (at most PCA9685_MOTION_MAX_SMOOTH).
+ * \param [in] motion -- Pointer to the motion state.
+ * \param [in] channel -- PWM channel number.
+ * \param [in] profile -- PCA9685_MOTION_TRAPEZOIDAL or PCA9685_MOTION_SCURVE.
+ * \param [in] maxVelocity -- Velocity limit, in counts per second.
+ * \param [in] maxAcceleration -- Acceleration limit, in counts per second squared.
+ * \param [in] maxJerk -- Jerk limit, in counts per second cubed. Ignored by trapezoidal profiles.
+ * \returns PCA9685LIB_SUCCESS if the limits are successfully set, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_MotionSetLimits(PCA9685Motion_t *motion, uint8_t channel, uint8_t profile, 
+                                float maxVelocity, float maxAcceleration, float maxJerk);
+
+/**
+ * \brief This function moves a channel to a position immediately, without a profile.
+ * \param [in] motion -- Pointer to the motion state.
+ * \param [in] channel -- PWM channel number.
+ * \param [in] position -- Pulse width, from 0 to PCA9685_MAX_PWM_VALUE.
+ * \returns PCA9685LIB_SUCCESS if the position is successfully set, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_MotionSetPosition(PCA9685Motion_t *motion, uint8_t channel, uint16_t position);
+
+/**
+ * \brief This function sets the target position of a channel. The channel moves
+ *        towards it on the following ticks.
+ * \param [in] motion -- Pointer to the motion state.
+ * \param [in] channel -- PWM channel number.
+ * \param [in] target -- Pulse width, from 0 to PCA9685_MAX_PWM_VALUE.
+ * \returns PCA9685LIB_SUCCESS if the target is successfully set, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_MotionSetTarget(PCA9685Motion_t *motion, uint8_t channel, uint16_t target);
+
+/**
+ * \brief This function advances every moving channel by one tick and commits the
+ *        channels whose pulse width changed in a single frame.
+ * \param [in] motion -- Pointer to the motion state.
+ * \returns PCA9685LIB_SUCCESS if the tick is successfully committed, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_MotionTick(PCA9685Motion_t *motion);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCA9685MOTION_H
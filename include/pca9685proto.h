@@ -0,0 +1,147 @@
+/*
+MIT License
+
+Copyright (c) 2024 Giuseppe Giglio <g.giglio001@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * \file pca9685proto.h
+ * \brief This file contains the binary protocol spoken by the pca9685d daemon
+ *       on its Unix socket.
+ *
+ * The socket is a SOCK_SEQPACKET socket, every datagram is one message. A
+ * message is a PCA9685ProtoHeader_t followed by one PCA9685ProtoChannel_t per
+ * bit set in channelMask, lowest channel first. Fields are in host byte order.
+ *
+ * - PCA9685_PROTO_OP_SET: the channels are merged with the other clients
+ *   requests and sent to the board on the next daemon tick. The reply has no
+ *   channels.
+ * - PCA9685_PROTO_OP_GET: the request has no channels. The reply carries the
+ *   requested channels whose value is known to the daemon.
+ * - PCA9685_PROTO_OP_SUBSCRIBE: the request has no channels and replaces the
+ *   subscription of the connection to the board, a zero mask cancels it. After
+ *   every tick that changed some of the channels, the daemon sends a
+ *   PCA9685_PROTO_OP_NOTIFY message with their new values.
+ * - PCA9685_PROTO_OP_SAFETY: the request has no channels and channelMask holds
+ *   PCA9685_SAFETY_* actions. The actions are run as soon as the request is
+ *   read, ahead of the pending channels, which are dropped. The board then
+ *   refuses SET requests with PCA9685_PROTO_STATUS_STOPPED until a
+ *   PCA9685_PROTO_OP_RESUME request. A zero i2cAddress addresses every board.
+ *
+ * Replies carry the request op, board and mask, with status set to one of the
+ * PCA9685_PROTO_STATUS_* values.
+ */
+
+#ifndef PCA9685PROTO_H
+#define PCA9685PROTO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Standard library includes */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Local includes */
+#include "pca9685lib.h"
+
+/* Macros */
+
+#define PCA9685_PROTO_SOCKET_PATH "/run/pca9685d.sock"
+
+#define PCA9685_PROTO_OP_SET ((uint8_t) 0x01U)
+#define PCA9685_PROTO_OP_GET ((uint8_t) 0x02U)
+#define PCA9685_PROTO_OP_SUBSCRIBE ((uint8_t) 0x03U)
+#define PCA9685_PROTO_OP_NOTIFY ((uint8_t) 0x04U)
+#define PCA9685_PROTO_OP_SAFETY ((uint8_t) 0x05U)
+#define PCA9685_PROTO_OP_RESUME ((uint8_t) 0x06U)
+
+#define PCA9685_PROTO_STATUS_OK ((uint8_t) 0x00U)
+#define PCA9685_PROTO_STATUS_BAD_REQUEST ((uint8_t) 0x01U)
+#define PCA9685_PROTO_STATUS_NO_BOARD ((uint8_t) 0x02U)
+#define PCA9685_PROTO_STATUS_STOPPED ((uint8_t) 0x03U)
+#define PCA9685_PROTO_STATUS_BUS_ERROR ((uint8_t) 0x04U)
+
+#define PCA9685_PROTO_ALL_BOARDS ((uint8_t) 0x00U) /** i2cAddress of SAFETY and RESUME for every board */
+
+#define PCA9685_PROTO_MAX_SIZE (sizeof(PCA9685ProtoHeader_t) \
+                                + PCA9685_MAX_PWM_CHANNELS * sizeof(PCA9685ProtoChannel_t))
+
+
+/* Typedefs */
+
+/**
+ * \struct PCA9685ProtoHeader_t "pca9685proto.h" pca9685proto.h
+ * \brief This structure is the header of every protocol message.
+*/
+typedef struct PCA9685ProtoHeader_s
+{
+    uint8_t op; /** PCA9685_PROTO_OP_* */
+    uint8_t status; /** PCA9685_PROTO_STATUS_* in replies, zero in requests */
+    uint8_t i2cAddress; /** I2C slave address of the board */
+    uint8_t reserved; /** Zero */
+    uint16_t i2cDevNumber; /** Linux I2C dev number of the board bus */
+    uint16_t channelMask; /** Channels carried or requested */
+} PCA9685ProtoHeader_t;
+
+/**
+ * \struct PCA9685ProtoChannel_t "pca9685proto.h" pca9685proto.h
+ * \brief This structure holds the value of a channel in a protocol message.
+*/
+typedef struct PCA9685ProtoChannel_s
+{
+    uint16_t onValue; /** ON value */
+    uint16_t offValue; /** OFF value */
+} PCA9685ProtoChannel_t;
+
+
+/* Functions declarations */
+
+/**
+ * \brief This function builds a protocol message.
+ * \param [out] message -- Pointer to a buffer of PCA9685_PROTO_MAX_SIZE bytes.
+ * \param [in] header -- Pointer to the message header.
+ * \param [in] frame -- Pointer to the frame holding the header channels, NULL
+ *                      for a message without channels.
+ * \returns The message size in bytes.
+*/
+size_t PCA9685_ProtoPack(uint8_t *message, const PCA9685ProtoHeader_t *header, 
+                            const PCA9685Frame_t *frame);
+
+/**
+ * \brief This function parses a protocol message.
+ * \param [in] message -- Pointer to the message.
+ * \param [in] size -- Message size in bytes.
+ * \param [out] header -- Pointer to the message header.
+ * \param [out] frame -- Pointer to the frame receiving the channels. Its mask is
+ *                       zero if the message carries no channels.
+ * \returns PCA9685LIB_SUCCESS if the message is well formed, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ProtoUnpack(const uint8_t *message, size_t size, PCA9685ProtoHeader_t *header, 
+                            PCA9685Frame_t *frame);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCA9685PROTO_H
@@ -0,0 +1,138 @@
+/*
+MIT License
+
+Copyright (c) 2024 Giuseppe Giglio <g.giglio001@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * \file pca9685scrub.h
+ * \brief This file contains the declarations of the state scrubber, which
+ *       verifies the boards against their shadow copy a slice at a time, within
+ *       a bus-time budget.
+ *
+ * Each board is visited in slices of a few channels, read back in one burst and
+ * repaired from the shadow copy where they differ. Every pass over a board
+ * starts with a MODE1 check, and a board found to have lost its state is
+ * restored at once with PCA9685_RestoreState. The bus time of the slices is
+ * measured and charged to a token bucket refilled at the configured budget, so
+ * the scrubber never takes more than its share of the bus on average whatever
+ * the tick rate. Boards shared with other threads must be thread-safe handles.
+ */
+
+#ifndef PCA9685SCRUB_H
+#define PCA9685SCRUB_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Standard library includes */
+#include <stdint.h>
+
+/* Local includes */
+#include "pca9685lib.h"
+
+/* Macros */
+
+#define PCA9685_SCRUB_MAX_BOARDS (16U)
+#define PCA9685_SCRUB_DEFAULT_SLICE ((uint8_t) 4U) /** Channels read back per slice */
+#define PCA9685_SCRUB_BURST_DIVIDER (10U) /** Bucket depth, as a fraction of the budget per second */
+#define PCA9685_SCRUB_RESTORED ((uint16_t) 0xFFFFU) /** Repaired mask of a restored board */
+
+
+/* Typedefs */
+
+/**
+ * \struct PCA9685ScrubStats_t "pca9685scrub.h" pca9685scrub.h
+ * \brief This structure holds the statistics of a scrubber.
+*/
+typedef struct PCA9685ScrubStats_s
+{
+    uint64_t slices; /** Slices verified */
+    uint64_t passes; /** Complete passes over a board */
+    uint64_t repairedChannels; /** Channels found corrupted and rewritten */
+    uint64_t restores; /** Boards found to have lost their state and restored */
+    uint64_t errors; /** Slices that failed on the bus */
+    uint64_t busNs; /** Bus time spent, in nanoseconds */
+} PCA9685ScrubStats_t;
+
+/**
+ * \struct PCA9685Scrubber_t "pca9685scrub.h" pca9685scrub.h
+ * \brief This structure holds the state of a scrubber.
+*/
+typedef struct PCA9685Scrubber_s
+{
+    PCA9685I2CConf_t *boards[PCA9685_SCRUB_MAX_BOARDS]; /** Scrubbed boards */
+    uint32_t boardCount; /** Number of boards */
+    uint32_t board; /** Board of the next slice */
+    uint8_t channel; /** First channel of the next slice */
+    uint8_t sliceChannels; /** Channels per slice */
+    uint32_t budgetNs; /** Bus time allowed per second, in nanoseconds */
+    int64_t tokensNs; /** Bus time available, negative after an overrun */
+    uint64_t lastNs; /** Time of the last refill */
+    PCA9685ScrubStats_t stats; /** Statistics */
+} PCA9685Scrubber_t;
+
+
+/* Functions declarations */
+
+/**
+ * \brief This function initializes a scrubber with no boards.
+ * \param [out] scrubber -- Pointer to the scrubber.
+ * \param [in] sliceChannels -- Channels read back per slice, from 1 to PCA9685_MAX_PWM_CHANNELS.
+ * \param [in] budgetNs -- Bus time allowed per second, in nanoseconds.
+ * \returns PCA9685LIB_SUCCESS if the scrubber is successfully initialized, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ScrubInit(PCA9685Scrubber_t *scrubber, uint8_t sliceChannels, uint32_t budgetNs);
+
+/**
+ * \brief This function adds a board to a scrubber.
+ * \param [in] scrubber -- Pointer to the scrubber.
+ * \param [in] board -- Pointer to the board configuration data structure.
+ * \returns PCA9685LIB_SUCCESS if the board is successfully added, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ScrubAddBoard(PCA9685Scrubber_t *scrubber, PCA9685I2CConf_t *board);
+
+/**
+ * \brief This function verifies as many slices as the budget allows since the
+ *        previous tick, at most one pass over every board.
+ * \param [in] scrubber -- Pointer to the scrubber.
+ * \param [out] repaired -- NULL, or an array of one entry per board, in the order they
+ *                          were added, set to the channels repaired during this tick;
+ *                          PCA9685_SCRUB_RESTORED for a restored board.
+ * \returns PCA9685LIB_SUCCESS if every slice is successfully verified, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ScrubTick(PCA9685Scrubber_t *scrubber, uint16_t *repaired);
+
+/**
+ * \brief This function gets the statistics of a scrubber.
+ * \param [in] scrubber -- Pointer to the scrubber.
+ * \param [out] stats -- Pointer to the statistics.
+ * \returns PCA9685LIB_SUCCESS if the statistics are successfully got, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ScrubGetStats(const PCA9685Scrubber_t *scrubber, PCA9685ScrubStats_t *stats);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCA9685SCRUB_H
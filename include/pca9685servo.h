@@ -0,0 +1,147 @@
+/*
+MIT License
+
+Copyright (c) 2024 Giuseppe Giglio <g.giglio001@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * \file pca9685servo.h
+ * \brief This file contains the declarations of the servo abstraction over a
+ *       PCA9685 channel, with per-channel calibration tables.
+ */
+
+#ifndef PCA9685SERVO_H
+#define PCA9685SERVO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Standard library includes */
+#include <stdint.h>
+
+/* Local includes */
+#include "pca9685lib.h"
+
+/* Macros */
+
+/* Number of calibration points spread evenly over the servo range */
+#define PCA9685_SERVO_LUT_SIZE (17U)
+
+/* Fractional bits of the angle-to-ticks lookup table */
+#define PCA9685_SERVO_LUT_FRAC_BITS (8U)
+
+/* Widest range whose angles fit int16_t tenths of a degree */
+#define PCA9685_SERVO_MAX_RANGE_DEG (3276U)
+
+
+/* Typedefs */
+
+/**
+ * \struct PCA9685Servo_t "pca9685servo.h" pca9685servo.h
+ * \brief This structure holds a servo wired to a channel of a board.
+ *        Angles are expressed in tenths of a degree, from 0 to rangeDeg * 10.
+*/
+typedef struct PCA9685Servo_s
+{
+    PCA9685I2CConf_t *board; /** Board the servo is wired to */
+    uint8_t channel; /** PWM channel number */
+    int8_t direction; /** 1, or -1 to mirror the angle */
+    int16_t trimUs; /** Center trim added to every pulse */
+    uint16_t rangeDeg; /** Mechanical range, in degrees */
+    uint16_t pulseUs[PCA9685_SERVO_LUT_SIZE]; /** Calibration pulse widths, evenly spaced over the range */
+    uint32_t lutTicks[PCA9685_SERVO_LUT_SIZE]; /** Calibration pulse widths in PWM counts, fixed point */
+    uint8_t lutPrescaler; /** Prescaler lutTicks was computed for */
+    uint8_t lutValid; /** Non-zero once lutTicks has been computed */
+    uint8_t batchPending; /** Used by PCA9685_ServoSetAngles to group servos by board */
+} PCA9685Servo_t;
+
+
+/* Functions declarations */
+
+/**
+ * \brief This function initializes a servo with a linear calibration.
+ * \param [out] servo -- Pointer to the servo.
+ * \param [in] board -- Pointer to the board configuration data structure.
+ * \param [in] channel -- PWM channel number.
+ * \param [in] minPulseUs -- Pulse width at angle 0, in microseconds.
+ * \param [in] maxPulseUs -- Pulse width at the end of the range, in microseconds.
+ * \param [in] rangeDeg -- Mechanical range, in degrees, up to PCA9685_SERVO_MAX_RANGE_DEG.
+ * \returns PCA9685LIB_SUCCESS if the servo is successfully initialized, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ServoInit(PCA9685Servo_t *servo, PCA9685I2CConf_t *board, uint8_t channel, 
+                            uint16_t minPulseUs, uint16_t maxPulseUs, uint16_t rangeDeg);
+
+/**
+ * \brief This function replaces the linear calibration of a servo with measured
+ *        pulse widths, evenly spaced from angle 0 to the end of the range.
+ * \param [in] servo -- Pointer to the servo.
+ * \param [in] pulseUs -- PCA9685_SERVO_LUT_SIZE pulse widths, in microseconds.
+ * \returns PCA9685LIB_SUCCESS if the calibration is successfully set, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ServoSetCalibration(PCA9685Servo_t *servo, const uint16_t *pulseUs);
+
+/**
+ * \brief This function sets the center trim and direction of a servo.
+ * \param [in] servo -- Pointer to the servo.
+ * \param [in] trimUs -- Offset added to every pulse, in microseconds.
+ * \param [in] direction -- 1, or -1 to mirror the angle.
+ * \returns PCA9685LIB_SUCCESS if the trim is successfully set, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ServoSetTrim(PCA9685Servo_t *servo, int16_t trimUs, int8_t direction);
+
+/**
+ * \brief This function converts an angle to a pulse width in PWM counts. The lookup
+ *        table is rebuilt only when the board prescaler has changed; a prescaler
+ *        the handle does not know yet is read back from the board first.
+ * \param [in] servo -- Pointer to the servo.
+ * \param [in] angle -- Angle, in tenths of a degree. Clamped to the servo range.
+ * \param [out] ticks -- Pulse width, in PWM counts.
+ * \returns PCA9685LIB_SUCCESS if the angle is successfully converted, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ServoAngleToTicks(PCA9685Servo_t *servo, int16_t angle, uint16_t *ticks);
+
+/**
+ * \brief This function sets the angle of a servo.
+ * \param [in] servo -- Pointer to the servo.
+ * \param [in] angle -- Angle, in tenths of a degree. Clamped to the servo range.
+ * \returns PCA9685LIB_SUCCESS if the angle is successfully set, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ServoSetAngle(PCA9685Servo_t *servo, int16_t angle);
+
+/**
+ * \brief This function sets the angles of many servos, possibly spread over several
+ *        boards, committing a single frame per board.
+ * \param [in] servos -- Array of servos.
+ * \param [in] angles -- Array of angles, in tenths of a degree.
+ * \param [in] count -- Number of servos.
+ * \returns PCA9685LIB_SUCCESS if every angle is successfully converted and every board
+ *          successfully committed, otherwise PCA9685LIB_ERROR. Servos whose angle cannot
+ *          be converted are left untouched.
+*/
+int16_t PCA9685_ServoSetAngles(PCA9685Servo_t *servos, const int16_t *angles, uint16_t count);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCA9685SERVO_H
@@ -0,0 +1,156 @@
+/*
+MIT License
+
+Copyright (c) 2024 Giuseppe Giglio <g.giglio001@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * \file pca9685shm.h
+ * \brief This file contains the declarations of the shared-memory frame
+ *       buffers through which client processes hand channel values to the
+ *       pca9685d daemon that owns the bus.
+ */
+
+#ifndef PCA9685SHM_H
+#define PCA9685SHM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Standard library includes */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Local includes */
+#include "pca9685lib.h"
+
+/* Macros */
+
+#define PCA9685_SHM_MAGIC ((uint32_t) 0x50394642U) /** "P9FB" */
+#define PCA9685_SHM_NAME_SIZE (32U)
+
+
+/* Typedefs */
+
+/**
+ * \struct PCA9685ShmFrame_t "pca9685shm.h" pca9685shm.h
+ * \brief This structure is the content of a board shared-memory frame buffer.
+ *        Writers exclude each other through owner, which holds the pid of the
+ *        process in a write section. The daemon releases the buffer of a
+ *        writer that died in its section, so clients must run in the PID
+ *        namespace of the daemon.
+*/
+typedef struct PCA9685ShmFrame_s
+{
+    uint32_t magic; /** PCA9685_SHM_MAGIC once the daemon has initialized the buffer */
+    uint32_t owner; /** Pid of the process in a write section, zero if none */
+    uint32_t seq; /** Sequence lock, odd while the buffer is being written */
+    uint32_t writingMask; /** Channels of the write section in progress */
+    uint32_t dirtyMask; /** Channels written since the last flush */
+    uint16_t onValue[PCA9685_MAX_PWM_CHANNELS]; /** ON values */
+    uint16_t offValue[PCA9685_MAX_PWM_CHANNELS]; /** OFF values */
+} PCA9685ShmFrame_t;
+
+/**
+ * \struct PCA9685ShmBuffer_t "pca9685shm.h" pca9685shm.h
+ * \brief This structure holds a process mapping of a board frame buffer.
+*/
+typedef struct PCA9685ShmBuffer_s
+{
+    PCA9685ShmFrame_t *frame; /** Shared frame buffer */
+    char name[PCA9685_SHM_NAME_SIZE]; /** POSIX shared memory object name */
+    uint8_t owner; /** Non-zero in the daemon, which removes the object on close */
+} PCA9685ShmBuffer_t;
+
+
+/* Functions declarations */
+
+/**
+ * \brief This function creates the frame buffer of a board. Used by the daemon.
+ * \param [out] buffer -- Pointer to the buffer mapping.
+ * \param [in] i2cDevNumber -- Linux I2C dev number of the board bus.
+ * \param [in] i2cAddress -- I2C slave address of the board.
+ * \returns PCA9685LIB_SUCCESS if the buffer is successfully created, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ShmCreate(PCA9685ShmBuffer_t *buffer, uint16_t i2cDevNumber, uint8_t i2cAddress);
+
+/**
+ * \brief This function maps the frame buffer of a board created by the daemon.
+ * \param [out] buffer -- Pointer to the buffer mapping.
+ * \param [in] i2cDevNumber -- Linux I2C dev number of the board bus.
+ * \param [in] i2cAddress -- I2C slave address of the board.
+ * \returns PCA9685LIB_SUCCESS if the buffer is successfully mapped, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ShmOpen(PCA9685ShmBuffer_t *buffer, uint16_t i2cDevNumber, uint8_t i2cAddress);
+
+/**
+ * \brief This function writes the masked channels of a frame to a frame buffer.
+ *        The daemon sends them to the board on its next flush.
+ * \param [in] buffer -- Pointer to the buffer mapping.
+ * \param [in] frame -- Pointer to the frame.
+ * \returns PCA9685LIB_SUCCESS if the frame is successfully written, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ShmWrite(PCA9685ShmBuffer_t *buffer, const PCA9685Frame_t *frame);
+
+/**
+ * \brief This function reads a consistent copy of a frame buffer without locking.
+ * \param [in] buffer -- Pointer to the buffer mapping.
+ * \param [out] frame -- Pointer to the frame, every channel is flagged.
+ * \returns PCA9685LIB_SUCCESS if the frame is successfully read, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ShmRead(PCA9685ShmBuffer_t *buffer, PCA9685Frame_t *frame);
+
+/**
+ * \brief This function moves the channels written since the last take or flush
+ *        into a frame, leaving the other channels of the frame untouched. Used by
+ *        the daemon to merge the buffer with other requests. If the buffer is
+ *        held by a process that no longer exists, the channels of its write
+ *        section are dropped and the buffer is released for the next take.
+ *        Channels holding out of range values are dropped and no longer flagged.
+ * \param [in] buffer -- Pointer to the buffer mapping.
+ * \param [in,out] frame -- Pointer to the frame the channels are merged into.
+ * \returns PCA9685LIB_SUCCESS if the channels are successfully taken, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ShmTake(PCA9685ShmBuffer_t *buffer, PCA9685Frame_t *frame);
+
+/**
+ * \brief This function commits the channels written since the last flush to the
+ *        board. Used by the daemon.
+ * \param [in] buffer -- Pointer to the buffer mapping.
+ * \param [in] board -- Pointer to the board configuration data structure.
+ * \returns PCA9685LIB_SUCCESS if the buffer is successfully flushed, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ShmFlush(PCA9685ShmBuffer_t *buffer, PCA9685I2CConf_t *board);
+
+/**
+ * \brief This function unmaps a frame buffer, removing it if created by this process.
+ * \param [in] buffer -- Pointer to the buffer mapping.
+ * \returns PCA9685LIB_SUCCESS if the buffer is successfully closed, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ShmClose(PCA9685ShmBuffer_t *buffer);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCA9685SHM_H
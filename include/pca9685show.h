@@ -0,0 +1,166 @@
+/*
+MIT License
+
+Copyright (c) 2024 Giuseppe Giglio <g.giglio001@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * \file pca9685show.h
+ * \brief This file contains the declarations of the player of precompiled
+ *       show files, streamed from a memory mapping to PCA9685 controllers.
+ *
+ * Show file format (little endian, every field 16-bit aligned):
+ *
+ *   Header, 16 bytes:
+ *     char     magic[4]     "P9SH"
+ *     uint16_t version      PCA9685_SHOW_VERSION
+ *     uint16_t boardCount   Number of boards addressed by the show
+ *     uint32_t tickUs       Tick period, in microseconds
+ *     uint32_t tickCount    Number of ticks following the header
+ *
+ *   Then tickCount ticks, back to back:
+ *     uint16_t recordCount  Number of board records in the tick
+ *     recordCount records:
+ *       uint16_t board        Board index, lower than boardCount
+ *       uint16_t channelMask  Channels changed since the previous tick
+ *       uint16_t duty[n]      New duty cycle of each flagged channel, in
+ *                             channel order, n being the popcount of channelMask
+ *
+ * Only channels whose value changes appear in a tick; an empty tick is a
+ * single zero recordCount.
+ */
+
+#ifndef PCA9685SHOW_H
+#define PCA9685SHOW_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Standard library includes */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Local includes */
+#include "pca9685lib.h"
+
+/* Macros */
+
+#define PCA9685_SHOW_MAGIC "P9SH"
+#define PCA9685_SHOW_VERSION ((uint16_t) 1U)
+
+/* Return code of PCA9685_ShowStep once the last tick has been played */
+#define PCA9685_SHOW_END ((int16_t) 1)
+
+/* Return code of PCA9685_ShowStep when the tick was played but a board commit failed */
+#define PCA9685_SHOW_COMMIT_FAILED ((int16_t) 2)
+
+
+/* Typedefs */
+
+/**
+ * \struct PCA9685ShowHeader_t "pca9685show.h" pca9685show.h
+ * \brief This structure maps the header of a show file.
+*/
+typedef struct PCA9685ShowHeader_s
+{
+    char magic[4]; /** PCA9685_SHOW_MAGIC */
+    uint16_t version; /** File format version */
+    uint16_t boardCount; /** Number of boards addressed by the show */
+    uint32_t tickUs; /** Tick period, in microseconds */
+    uint32_t tickCount; /** Number of ticks */
+} PCA9685ShowHeader_t;
+
+/**
+ * \struct PCA9685Show_t "pca9685show.h" pca9685show.h
+ * \brief This structure holds a memory-mapped show and its playback position.
+*/
+typedef struct PCA9685Show_s
+{
+    const uint8_t *map; /** Start of the file mapping */
+    size_t mapSize; /** Size of the file mapping */
+    const PCA9685ShowHeader_t *header; /** File header */
+    const uint16_t *cursor; /** Next tick to play */
+    const uint16_t *end; /** End of the file mapping */
+    uint32_t tick; /** Index of the next tick to play */
+    uint32_t commitFailures; /** Board commits that failed since the last rewind */
+} PCA9685Show_t;
+
+
+/* Functions declarations */
+
+/**
+ * \brief This function maps a show file and checks its header.
+ * \param [out] show -- Pointer to the show.
+ * \param [in] path -- Path of the show file.
+ * \returns PCA9685LIB_SUCCESS if the show is successfully opened, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ShowOpen(PCA9685Show_t *show, const char *path);
+
+/**
+ * \brief This function moves the playback position back to the first tick.
+ * \param [in] show -- Pointer to the show.
+ * \returns PCA9685LIB_SUCCESS if the show is successfully rewound, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ShowRewind(PCA9685Show_t *show);
+
+/**
+ * \brief This function plays the next tick of a show, committing one frame per
+ *        board that has changes.
+ * \param [in] show -- Pointer to the show.
+ * \param [in] boards -- Array of boards, indexed as in the show.
+ * \param [in] frames -- Array of boardCount frames used as scratch.
+ * \param [in] boardCount -- Number of boards, at least the show board count.
+ * \returns PCA9685LIB_SUCCESS if the tick is successfully played, PCA9685_SHOW_END
+ *          if there are no more ticks, PCA9685_SHOW_COMMIT_FAILED if the tick was
+ *          played but a board commit failed, otherwise PCA9685LIB_ERROR if the
+ *          tick is malformed.
+*/
+int16_t PCA9685_ShowStep(PCA9685Show_t *show, PCA9685I2CConf_t **boards, PCA9685Frame_t *frames, 
+                            uint16_t boardCount);
+
+/**
+ * \brief This function plays a show to its end, one tick per tick period,
+ *        scheduled on absolute monotonic deadlines so that timing does not drift.
+ *        Failed board commits are counted in commitFailures and do not stop
+ *        the show, only a malformed tick does.
+ * \param [in] show -- Pointer to the show.
+ * \param [in] boards -- Array of boards, indexed as in the show.
+ * \param [in] frames -- Array of boardCount frames used as scratch.
+ * \param [in] boardCount -- Number of boards, at least the show board count.
+ * \returns PCA9685LIB_SUCCESS if the show is successfully played, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ShowPlay(PCA9685Show_t *show, PCA9685I2CConf_t **boards, PCA9685Frame_t *frames, 
+                            uint16_t boardCount);
+
+/**
+ * \brief This function unmaps a show file.
+ * \param [in] show -- Pointer to the show.
+ * \returns PCA9685LIB_SUCCESS if the show is successfully closed, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_ShowClose(PCA9685Show_t *show);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCA9685SHOW_H
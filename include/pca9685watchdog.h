@@ -0,0 +1,146 @@
+/*
+MIT License
+
+Copyright (c) 2024 Giuseppe Giglio <g.giglio001@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * \file pca9685watchdog.h
+ * \brief This file contains the declarations of the safety watchdog, which
+ *       drives the boards to a fail-safe state when the application stops
+ *       kicking it.
+ *
+ * The fail-safe frame of each board is converted to register values when the
+ * board is added, so that tripping costs a single 64-byte burst per board,
+ * followed by the optional output-disable and sleep actions. The watchdog
+ * thread sleeps on the deadline and takes no bus time while it is kicked.
+ * Boards are switched to thread-safe mode when added, as the watchdog writes
+ * to them from its own thread.
+ */
+
+#ifndef PCA9685WATCHDOG_H
+#define PCA9685WATCHDOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Standard library includes */
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+
+/* Local includes */
+#include "pca9685lib.h"
+
+/* Macros */
+
+#define PCA9685_WATCHDOG_MAX_BOARDS (16U)
+
+
+/* Typedefs */
+
+/**
+ * \struct PCA9685Watchdog_t "pca9685watchdog.h" pca9685watchdog.h
+ * \brief This structure holds the state of a watchdog.
+*/
+typedef struct PCA9685Watchdog_s
+{
+    pthread_t thread; /** Watchdog thread */
+    pthread_mutex_t mutex; /** Guards the deadline and the flags */
+    pthread_cond_t kicked; /** Signaled when the watchdog is kicked or stopped */
+    PCA9685I2CConf_t *boards[PCA9685_WATCHDOG_MAX_BOARDS]; /** Watched boards */
+    uint8_t failSafe[PCA9685_WATCHDOG_MAX_BOARDS][PCA9685_LED_REGS_SIZE]; /** Fail-safe LEDn registers */
+    uint32_t boardCount; /** Number of boards */
+    uint32_t timeoutMs; /** Time allowed between kicks, in milliseconds */
+    uint8_t actions; /** PCA9685_SAFETY_DISABLE_OUTPUT and PCA9685_SAFETY_SLEEP actions */
+    struct timespec deadline; /** CLOCK_MONOTONIC time the watchdog trips at */
+    uint64_t trips; /** Number of times the watchdog tripped */
+    int16_t tripStatus; /** Status of the last trip */
+    uint8_t tripped; /** Non-zero once tripped, until the next kick */
+    uint8_t running; /** Non-zero while the thread runs */
+} PCA9685Watchdog_t;
+
+
+/* Functions declarations */
+
+/**
+ * \brief This function initializes a watchdog with no boards.
+ * \param [out] watchdog -- Pointer to the watchdog.
+ * \param [in] timeoutMs -- Time allowed between kicks, in milliseconds.
+ * \param [in] actions -- PCA9685_SAFETY_DISABLE_OUTPUT and PCA9685_SAFETY_SLEEP actions
+ *                        run after the fail-safe frame is written, zero for none.
+ * \returns PCA9685LIB_SUCCESS if the watchdog is successfully initialized, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_WatchdogInit(PCA9685Watchdog_t *watchdog, uint32_t timeoutMs, uint8_t actions);
+
+/**
+ * \brief This function adds a board to a stopped watchdog and switches it to
+ *        thread-safe mode.
+ * \param [in] watchdog -- Pointer to the watchdog.
+ * \param [in] board -- Pointer to the board configuration data structure.
+ * \param [in] failSafe -- Pointer to the fail-safe frame, channels outside its mask are
+ *                         set full OFF; NULL for every channel full OFF.
+ * \returns PCA9685LIB_SUCCESS if the board is successfully added, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_WatchdogAddBoard(PCA9685Watchdog_t *watchdog, PCA9685I2CConf_t *board, 
+                                    const PCA9685Frame_t *failSafe);
+
+/**
+ * \brief This function arms the watchdog and starts its thread.
+ * \param [in] watchdog -- Pointer to the watchdog.
+ * \returns PCA9685LIB_SUCCESS if the watchdog is successfully started, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_WatchdogStart(PCA9685Watchdog_t *watchdog);
+
+/**
+ * \brief This function pushes the deadline back by the timeout. A tripped watchdog
+ *        is armed again, and stops writing fail-safe frames if the trip is still
+ *        in progress. Boards already tripped keep their fail-safe outputs until
+ *        the application writes to them. With PCA9685_SAFETY_SLEEP, LED writes do
+ *        not wake them up: the application must call PCA9685_FastResume first.
+ * \param [in] watchdog -- Pointer to the watchdog.
+ * \returns PCA9685LIB_SUCCESS if the watchdog is successfully kicked, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_WatchdogKick(PCA9685Watchdog_t *watchdog);
+
+/**
+ * \brief This function gets the number of times the watchdog tripped.
+ * \param [in] watchdog -- Pointer to the watchdog.
+ * \param [out] trips -- Pointer to the number of trips.
+ * \param [out] tripStatus -- NULL, or pointer to the status of the last trip.
+ * \returns PCA9685LIB_SUCCESS if the trips are successfully got, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_WatchdogGetTrips(PCA9685Watchdog_t *watchdog, uint64_t *trips, int16_t *tripStatus);
+
+/**
+ * \brief This function stops and joins the watchdog thread, leaving the boards as they are.
+ * \param [in] watchdog -- Pointer to the watchdog.
+ * \returns PCA9685LIB_SUCCESS if the watchdog is successfully stopped, otherwise PCA9685LIB_ERROR.
+*/
+int16_t PCA9685_WatchdogStop(PCA9685Watchdog_t *watchdog);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCA9685WATCHDOG_H
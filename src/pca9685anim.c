@@ -0,0 +1,310 @@
+/*
+MIT License
+
+Copyright (c) 2024 Giuseppe Giglio <g.giglio001@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * \file pca9685anim.c
+ * \brief This file contains the definitions of the keyframe animation engine
+ *       that drives PCA9685 channels from per-channel tracks.
+ */
+
+/* Standard library includes */
+#include <stdlib.h>
+#include <string.h>
+
+/* Local includes */
+#include "pca9685anim.h"
+#include "pca9685lib.h"
+
+
+
+/* Unexported functions definitions */
+
+/**
+ * \brief This function maps a segment position through an easing curve.
+ * \param [in] interp -- Interpolation mode.
+ * \param [in] t -- Position in the segment, from 0 to PCA9685_ANIM_ONE.
+ * \returns The eased position, from 0 to PCA9685_ANIM_ONE.
+ */
+uint32_t PCA9685AnimEase(uint8_t interp, uint32_t t)
+{
+    uint32_t inv = PCA9685_ANIM_ONE - t; /** Remaining part of the segment */
+
+    switch (interp)
+    {
+        case PCA9685_ANIM_EASE_IN:
+            return (uint32_t) (((uint64_t) t * t) >> PCA9685_ANIM_FRAC_BITS);
+
+        case PCA9685_ANIM_EASE_OUT:
+            return PCA9685_ANIM_ONE - (uint32_t) (((uint64_t) inv * inv) >> PCA9685_ANIM_FRAC_BITS);
+
+        case PCA9685_ANIM_EASE_IN_OUT:
+            /* 3t^2 - 2t^3 */
+            return (uint32_t) (((((uint64_t) t * t) >> PCA9685_ANIM_FRAC_BITS) 
+                                * ((3U * PCA9685_ANIM_ONE) - (2U * t))) >> PCA9685_ANIM_FRAC_BITS);
+
+        default:
+            return t;
+    }
+}
+
+/**
+ * \brief This function evaluates a track segment.
+ * \param [in] track -- Pointer to the track.
+ * \param [in] t -- Position in the segment, from 0 to PCA9685_ANIM_ONE.
+ * \returns The duty cycle of the channel.
+ */
+uint16_t PCA9685AnimEvalSegment(const PCA9685AnimTrack_t *track, uint32_t t)
+{
+    const PCA9685Keyframe_t *key = &track->keys[track->cursor]; /** Segment start keyframe */
+    int32_t p1 = (int32_t) key[0].value; /** Segment start value */
+    int32_t p2 = (int32_t) key[1].value; /** Segment end value */
+    int32_t p0 = p1; /** Value before the segment */
+    int32_t p3 = p2; /** Value after the segment */
+    int64_t t2 = 0; /** Position squared */
+    int64_t t3 = 0; /** Position cubed */
+    int64_t sum = 0; /** Catmull-Rom polynomial, scaled by 2 * PCA9685_ANIM_ONE */
+
+    switch (key->interp)
+    {
+        case PCA9685_ANIM_STEP:
+            return (uint16_t) p1;
+
+        case PCA9685_ANIM_CUBIC:
+            if (track->cursor > 0U)
+            {
+                p0 = (int32_t) key[-1].value;
+            }
+
+            if ((track->cursor + 2U) < track->keyCount)
+            {
+                p3 = (int32_t) key[2].value;
+            }
+
+            t2 = ((int64_t) t * t) >> PCA9685_ANIM_FRAC_BITS;
+            t3 = (t2 * t) >> PCA9685_ANIM_FRAC_BITS;
+
+            sum = ((int64_t) (2 * p1) << PCA9685_ANIM_FRAC_BITS)
+                    + ((int64_t) (p2 - p0) * t)
+                    + ((int64_t) ((2 * p0) - (5 * p1) + (4 * p2) - p3) * t2)
+                    + ((int64_t) ((3 * p1) - p0 - (3 * p2) + p3) * t3);
+
+            /* The spline may overshoot between keyframes */
+            sum >>= (PCA9685_ANIM_FRAC_BITS + 1U);
+
+            if (sum < 0)
+            {
+                return 0U;
+            }
+
+            return (sum > PCA9685_MAX_PWM_VALUE) ? PCA9685_MAX_PWM_VALUE : (uint16_t) sum;
+
+        default:
+            t = PCA9685AnimEase(key->interp, t);
+
+            return (uint16_t) (p1 + (int32_t) (((int64_t) (p2 - p1) * t) >> PCA9685_ANIM_FRAC_BITS));
+    }
+}
+
+/**
+ * \brief This function evaluates a track at the given time, advancing its cursor.
+ * \param [in] track -- Pointer to the track.
+ * \param [in] nowMs -- Current animation time.
+ * \returns The duty cycle of the channel.
+ */
+uint16_t PCA9685AnimEvalTrack(PCA9685AnimTrack_t *track, uint32_t nowMs)
+{
+    const PCA9685Keyframe_t *keys = track->keys; /** Track keyframes */
+    uint32_t firstMs = keys[0].timeMs; /** Time of the first keyframe */
+    uint32_t lastMs = keys[track->keyCount - 1U].timeMs; /** Time of the last keyframe */
+    uint32_t elapsed = nowMs - track->startMs; /** Time from the start of the track */
+    uint32_t span = 0U; /** Duration of the current segment */
+
+    if (elapsed >= lastMs)
+    {
+        if (track->loop == 0U || lastMs == firstMs)
+        {
+            track->active = 0U;
+
+            return keys[track->keyCount - 1U].value;
+        }
+
+        elapsed = firstMs + ((elapsed - firstMs) % (lastMs - firstMs));
+    }
+
+    if (elapsed < firstMs)
+    {
+        return keys[0].value;
+    }
+
+    /* Time went backwards or the track looped */
+    if (elapsed < keys[track->cursor].timeMs)
+    {
+        track->cursor = 0U;
+    }
+
+    /* Amortized O(1): the cursor only moves forward between ticks */
+    while (elapsed >= keys[track->cursor + 1U].timeMs)
+    {
+        track->cursor++;
+    }
+
+    span = keys[track->cursor + 1U].timeMs - keys[track->cursor].timeMs;
+
+    return PCA9685AnimEvalSegment(track, (uint32_t) ((((uint64_t) (elapsed - keys[track->cursor].timeMs)) 
+                                                        << PCA9685_ANIM_FRAC_BITS) / span));
+}
+
+/* Exported Functions Definitions */
+
+int16_t PCA9685_AnimInit(PCA9685Anim_t *anim, PCA9685I2CConf_t **boards, PCA9685Frame_t *frames, 
+                            uint8_t boardCount, PCA9685AnimTrack_t *tracks, uint16_t trackCount)
+{
+
+    /* Verifying input */
+    if (anim == NULL || boards == NULL || frames == NULL || tracks == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    anim->boards = boards;
+    anim->frames = frames;
+    anim->boardCount = boardCount;
+    anim->tracks = tracks;
+    anim->trackCount = trackCount;
+
+    memset(tracks, 0, trackCount * sizeof(PCA9685AnimTrack_t));
+    memset(frames, 0, boardCount * sizeof(PCA9685Frame_t));
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_AnimStartTrack(PCA9685Anim_t *anim, uint16_t track, uint8_t board, uint8_t channel, 
+                                const PCA9685Keyframe_t *keys, uint16_t keyCount, uint8_t loop, 
+                                uint32_t nowMs)
+{
+    PCA9685AnimTrack_t *slot = NULL; /** Track slot */
+    uint16_t key = 0U; /** Keyframe index */
+
+    /* Verifying input */
+    if (anim == NULL || keys == NULL || keyCount == 0U)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (track >= anim->trackCount || board >= anim->boardCount 
+            || channel >= PCA9685_MAX_PWM_CHANNELS)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    /* Keyframes are validated once here, so ticks need no checks */
+    for (key = 0U; key < keyCount; key++)
+    {
+        if (keys[key].value > PCA9685_MAX_PWM_VALUE || keys[key].interp > PCA9685_ANIM_EASE_IN_OUT)
+        {
+            return PCA9685LIB_ERROR;
+        }
+
+        if (key > 0U && keys[key].timeMs <= keys[key - 1U].timeMs)
+        {
+            return PCA9685LIB_ERROR;
+        }
+    }
+
+    slot = &anim->tracks[track];
+
+    slot->keys = keys;
+    slot->keyCount = keyCount;
+    slot->cursor = 0U;
+    slot->startMs = nowMs - keys[0].timeMs;
+    slot->board = board;
+    slot->channel = channel;
+    slot->loop = loop;
+    slot->active = 1U;
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_AnimStopTrack(PCA9685Anim_t *anim, uint16_t track)
+{
+
+    /* Verifying input */
+    if (anim == NULL || track >= anim->trackCount)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    anim->tracks[track].active = 0U;
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_AnimTick(PCA9685Anim_t *anim, uint32_t nowMs)
+{
+    int16_t result = PCA9685LIB_SUCCESS; /** Aggregated commit result */
+    PCA9685AnimTrack_t *track = NULL; /** Track being evaluated */
+    uint16_t index = 0U; /** Track index */
+    uint8_t board = 0U; /** Board index */
+
+    /* Verifying input */
+    if (anim == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    for (board = 0U; board < anim->boardCount; board++)
+    {
+        anim->frames[board].channelMask = 0U;
+    }
+
+    /* Evaluating tracks */
+    for (index = 0U; index < anim->trackCount; index++)
+    {
+        track = &anim->tracks[index];
+
+        if (track->active == 0U)
+        {
+            continue;
+        }
+
+        (void) PCA9685_FrameSetDuty(&anim->frames[track->board], track->channel, 
+                                    PCA9685AnimEvalTrack(track, nowMs));
+    }
+
+    /* Committing one frame per board, a failing board does not stop the others */
+    for (board = 0U; board < anim->boardCount; board++)
+    {
+        if (anim->frames[board].channelMask == 0U)
+        {
+            continue;
+        }
+
+        if (PCA9685_CommitFrame(anim->boards[board], &anim->frames[board]) != PCA9685LIB_SUCCESS)
+        {
+            result = PCA9685LIB_ERROR;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,262 @@
+/*
+MIT License
+
+Copyright (c) 2024 Giuseppe Giglio <g.giglio001@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * \file pca9685buslock.c
+ * \brief This file contains the definitions of the per-bus registries of the
+ *       locks used by thread-safe handles and of the bus cost estimators.
+ */
+
+/* Standard library includes */
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+/* Local includes */
+#include "pca9685buslock.h"
+#include "pca9685lib.h"
+
+
+/* Unexported macros */
+
+/** Maximum number of buses locked at the same time */
+#define PCA9685_MAX_BUS_LOCKS (16U)
+
+
+/* Unexported typedefs */
+
+/**
+ * \struct PCA9685BusLock_t
+ * \brief This structure holds the lock shared by the thread-safe handles of a bus.
+*/
+struct PCA9685BusLock_s
+{
+    pthread_mutex_t mutex; /** Recursive bus mutex */
+    uint16_t i2cDevNumber; /** Linux I2C dev number of the bus */
+    uint32_t references; /** Handles using the lock, zero if the slot is free */
+    uint32_t depth; /** Recursion depth of the owner */
+    uint64_t acquiredNs; /** Time of the outermost acquisition */
+    PCA9685LockStats_t stats; /** Contention statistics */
+};
+
+/**
+ * \struct PCA9685BusEstimator_t
+ * \brief This structure holds the cost estimator shared by the handles of a bus.
+*/
+struct PCA9685BusEstimator_s
+{
+    pthread_mutex_t mutex; /** Guards estimator */
+    uint16_t i2cDevNumber; /** Linux I2C dev number of the bus */
+    uint32_t references; /** Handles using the estimator, zero if the slot is free */
+    PCA9685CostEstimator_t estimator; /** Regression sums and fitted model */
+};
+
+
+/* Unexported variables */
+
+static pthread_mutex_t registryMutex = PTHREAD_MUTEX_INITIALIZER; /** Guards busLocks */
+static PCA9685BusLock_t busLocks[PCA9685_MAX_BUS_LOCKS]; /** Lock registry */
+static PCA9685BusEstimator_t busEstimators[PCA9685_MAX_BUS_LOCKS]; /** Estimator registry */
+
+
+/* Functions definitions */
+
+uint64_t PCA9685MonotonicNs(void)
+{
+    struct timespec now; /** Current time */
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t) now.tv_sec * 1000000000U) + (uint64_t) now.tv_nsec;
+}
+
+PCA9685BusLock_t *PCA9685BusLockGet(uint16_t i2cDevNumber)
+{
+    pthread_mutexattr_t attributes; /** Mutex attributes */
+    PCA9685BusLock_t *busLock = NULL; /** Lock of the bus */
+    PCA9685BusLock_t *freeSlot = NULL; /** First free registry slot */
+    uint32_t i = 0U; /** Registry index */
+
+    pthread_mutex_lock(&registryMutex);
+
+    for (i = 0U; i < PCA9685_MAX_BUS_LOCKS && busLock == NULL; i++)
+    {
+        if (busLocks[i].references == 0U)
+        {
+            freeSlot = (freeSlot == NULL) ? &busLocks[i] : freeSlot;
+        }
+        else if (busLocks[i].i2cDevNumber == i2cDevNumber)
+        {
+            busLock = &busLocks[i];
+        }
+    }
+
+    if (busLock == NULL && freeSlot != NULL)
+    {
+        busLock = freeSlot;
+        memset(busLock, 0, sizeof(PCA9685BusLock_t));
+
+        pthread_mutexattr_init(&attributes);
+        pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutex_init(&busLock->mutex, &attributes);
+        pthread_mutexattr_destroy(&attributes);
+
+        busLock->i2cDevNumber = i2cDevNumber;
+    }
+
+    if (busLock != NULL)
+    {
+        busLock->references++;
+    }
+
+    pthread_mutex_unlock(&registryMutex);
+
+    return busLock;
+}
+
+void PCA9685BusLockPut(PCA9685BusLock_t *busLock)
+{
+    pthread_mutex_lock(&registryMutex);
+
+    if (--busLock->references == 0U)
+    {
+        pthread_mutex_destroy(&busLock->mutex);
+    }
+
+    pthread_mutex_unlock(&registryMutex);
+}
+
+void PCA9685BusLockAcquire(PCA9685BusLock_t *busLock)
+{
+    uint64_t startNs = 0U; /** Time the wait started */
+    uint64_t waitNs = 0U; /** Time spent waiting */
+
+    if (pthread_mutex_trylock(&busLock->mutex) != 0)
+    {
+        startNs = PCA9685MonotonicNs();
+        pthread_mutex_lock(&busLock->mutex);
+        waitNs = PCA9685MonotonicNs() - startNs;
+
+        busLock->stats.contended++;
+        busLock->stats.waitNs += waitNs;
+
+        if (waitNs > busLock->stats.maxWaitNs)
+        {
+            busLock->stats.maxWaitNs = waitNs;
+        }
+    }
+
+    /* Nested acquisitions never wait and are not counted */
+    if (busLock->depth++ == 0U)
+    {
+        busLock->stats.acquisitions++;
+        busLock->acquiredNs = PCA9685MonotonicNs();
+    }
+}
+
+void PCA9685BusLockRelease(PCA9685BusLock_t *busLock)
+{
+    if (--busLock->depth == 0U)
+    {
+        busLock->stats.holdNs += PCA9685MonotonicNs() - busLock->acquiredNs;
+    }
+
+    pthread_mutex_unlock(&busLock->mutex);
+}
+
+void PCA9685BusLockStats(PCA9685BusLock_t *busLock, PCA9685LockStats_t *stats, uint8_t reset)
+{
+    pthread_mutex_lock(&busLock->mutex);
+
+    *stats = busLock->stats;
+
+    if (reset != 0U)
+    {
+        memset(&busLock->stats, 0, sizeof(busLock->stats));
+    }
+
+    pthread_mutex_unlock(&busLock->mutex);
+}
+
+PCA9685BusEstimator_t *PCA9685BusEstimatorGet(uint16_t i2cDevNumber)
+{
+    PCA9685BusEstimator_t *busEstimator = NULL; /** Estimator of the bus */
+    PCA9685BusEstimator_t *freeSlot = NULL; /** First free registry slot */
+    uint32_t i = 0U; /** Registry index */
+
+    pthread_mutex_lock(&registryMutex);
+
+    for (i = 0U; i < PCA9685_MAX_BUS_LOCKS && busEstimator == NULL; i++)
+    {
+        if (busEstimators[i].references == 0U)
+        {
+            freeSlot = (freeSlot == NULL) ? &busEstimators[i] : freeSlot;
+        }
+        else if (busEstimators[i].i2cDevNumber == i2cDevNumber)
+        {
+            busEstimator = &busEstimators[i];
+        }
+    }
+
+    if (busEstimator == NULL && freeSlot != NULL)
+    {
+        busEstimator = freeSlot;
+        memset(busEstimator, 0, sizeof(PCA9685BusEstimator_t));
+        pthread_mutex_init(&busEstimator->mutex, NULL);
+        busEstimator->i2cDevNumber = i2cDevNumber;
+    }
+
+    if (busEstimator != NULL)
+    {
+        busEstimator->references++;
+    }
+
+    pthread_mutex_unlock(&registryMutex);
+
+    return busEstimator;
+}
+
+void PCA9685BusEstimatorPut(PCA9685BusEstimator_t *busEstimator)
+{
+    pthread_mutex_lock(&registryMutex);
+
+    if (--busEstimator->references == 0U)
+    {
+        pthread_mutex_destroy(&busEstimator->mutex);
+    }
+
+    pthread_mutex_unlock(&registryMutex);
+}
+
+PCA9685CostEstimator_t *PCA9685BusEstimatorAcquire(PCA9685BusEstimator_t *busEstimator)
+{
+    pthread_mutex_lock(&busEstimator->mutex);
+
+    return &busEstimator->estimator;
+}
+
+void PCA9685BusEstimatorRelease(PCA9685BusEstimator_t *busEstimator)
+{
+    pthread_mutex_unlock(&busEstimator->mutex);
+}
@@ -0,0 +1,110 @@
+/*
+MIT License
+
+Copyright (c) 2024 Giuseppe Giglio <g.giglio001@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * \file pca9685buslock.h
+ * \brief This file contains the declarations of the per-bus registries of the
+ *       locks used by thread-safe handles and of the bus cost estimators, and of
+ *       the monotonic clock shared by the library modules.
+ *       Not part of the public interface.
+ */
+
+#ifndef PCA9685BUSLOCK_H
+#define PCA9685BUSLOCK_H
+
+/* Standard library includes */
+#include <stdint.h>
+
+/* Local includes */
+#include "pca9685lib.h"
+
+
+/* Functions declarations */
+
+/**
+ * \brief This function returns the value of the monotonic clock.
+ * \returns The monotonic time, in nanoseconds.
+ */
+uint64_t PCA9685MonotonicNs(void);
+
+/**
+ * \brief This function gets the lock of a bus, creating it on first use.
+ * \param [in] i2cDevNumber -- Linux I2C dev number of the bus.
+ * \returns Pointer to the bus lock, NULL if the registry is full.
+ */
+PCA9685BusLock_t *PCA9685BusLockGet(uint16_t i2cDevNumber);
+
+/**
+ * \brief This function drops a reference to a bus lock got with PCA9685BusLockGet.
+ * \param [in] busLock -- Pointer to the bus lock.
+ */
+void PCA9685BusLockPut(PCA9685BusLock_t *busLock);
+
+/**
+ * \brief This function acquires a bus lock. The lock is recursive.
+ * \param [in] busLock -- Pointer to the bus lock.
+ */
+void PCA9685BusLockAcquire(PCA9685BusLock_t *busLock);
+
+/**
+ * \brief This function releases a bus lock.
+ * \param [in] busLock -- Pointer to the bus lock.
+ */
+void PCA9685BusLockRelease(PCA9685BusLock_t *busLock);
+
+/**
+ * \brief This function copies the statistics of a bus lock.
+ * \param [in] busLock -- Pointer to the bus lock.
+ * \param [out] stats -- Pointer to the statistics.
+ * \param [in] reset -- Non-zero to clear the statistics after the copy.
+ */
+void PCA9685BusLockStats(PCA9685BusLock_t *busLock, PCA9685LockStats_t *stats, uint8_t reset);
+
+/**
+ * \brief This function gets the cost estimator of a bus, creating it on first use.
+ * \param [in] i2cDevNumber -- Linux I2C dev number of the bus.
+ * \returns Pointer to the bus estimator, NULL if the registry is full.
+ */
+PCA9685BusEstimator_t *PCA9685BusEstimatorGet(uint16_t i2cDevNumber);
+
+/**
+ * \brief This function drops a reference to a bus estimator got with PCA9685BusEstimatorGet.
+ * \param [in] busEstimator -- Pointer to the bus estimator.
+ */
+void PCA9685BusEstimatorPut(PCA9685BusEstimator_t *busEstimator);
+
+/**
+ * \brief This function locks a bus estimator for an update.
+ * \param [in] busEstimator -- Pointer to the bus estimator.
+ * \returns Pointer to the estimator sums, valid until PCA9685BusEstimatorRelease.
+ */
+PCA9685CostEstimator_t *PCA9685BusEstimatorAcquire(PCA9685BusEstimator_t *busEstimator);
+
+/**
+ * \brief This function unlocks a bus estimator.
+ * \param [in] busEstimator -- Pointer to the bus estimator.
+ */
+void PCA9685BusEstimatorRelease(PCA9685BusEstimator_t *busEstimator);
+
+#endif // PCA9685BUSLOCK_H
@@ -0,0 +1,316 @@
+/*
+MIT License
+
+Copyright (c) 2024 Giuseppe Giglio <g.giglio001@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * \file pca9685client.c
+ * \brief This file contains the definitions of the pca9685d client functions.
+ */
+
+/* Standard library includes */
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/* Local includes */
+#include "pca9685client.h"
+#include "pca9685proto.h"
+#include "pca9685lib.h"
+
+
+
+/* Unexported functions definitions */
+
+/**
+ * \brief This function receives the next message of a connection.
+ * \param [in] client -- Pointer to the connection.
+ * \param [out] header -- Pointer to the message header.
+ * \param [out] frame -- Pointer to the frame receiving the message channels.
+ * \param [in] timeoutMs -- Timeout in milliseconds, negative to wait forever.
+ * \returns PCA9685LIB_SUCCESS if a well formed message is received, otherwise PCA9685LIB_ERROR.
+ */
+int16_t PCA9685ClientReceive(PCA9685Client_t *client, PCA9685ProtoHeader_t *header, 
+                                PCA9685Frame_t *frame, int timeoutMs)
+{
+    uint8_t message[PCA9685_PROTO_MAX_SIZE]; /** Received message */
+    struct pollfd pfd; /** Socket poll descriptor */
+    ssize_t size = 0; /** Received size */
+    int ready = 0; /** Poll result */
+
+    pfd.fd = client->fd;
+    pfd.events = POLLIN;
+
+    do
+    {
+        ready = poll(&pfd, 1, timeoutMs);
+    } while (ready < 0 && errno == EINTR);
+
+    if (ready <= 0)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    size = recv(client->fd, message, sizeof(message), 0);
+
+    if (size <= 0)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    return PCA9685_ProtoUnpack(message, (size_t) size, header, frame);
+}
+
+/**
+ * \brief This function sends a request and waits for its reply.
+ * \param [in] client -- Pointer to the connection.
+ * \param [in,out] header -- Pointer to the request header, replaced by the reply header.
+ * \param [in] request -- Pointer to the request channels, NULL if none.
+ * \param [out] reply -- Pointer to the frame receiving the reply channels.
+ * \returns PCA9685LIB_SUCCESS if the daemon replies with PCA9685_PROTO_STATUS_OK,
+ *          otherwise PCA9685LIB_ERROR.
+ */
+int16_t PCA9685ClientRequest(PCA9685Client_t *client, PCA9685ProtoHeader_t *header, 
+                                const PCA9685Frame_t *request, PCA9685Frame_t *reply)
+{
+    uint8_t message[PCA9685_PROTO_MAX_SIZE]; /** Request message */
+    size_t size = 0U; /** Request size */
+    uint8_t op = header->op; /** Request op */
+
+    size = PCA9685_ProtoPack(message, header, request);
+
+    if (send(client->fd, message, size, MSG_NOSIGNAL) != (ssize_t) size)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    /* Requests are served in order, only notifications can come first */
+    do
+    {
+        if (PCA9685ClientReceive(client, header, reply, -1) != PCA9685LIB_SUCCESS)
+        {
+            return PCA9685LIB_ERROR;
+        }
+    } while (header->op == PCA9685_PROTO_OP_NOTIFY);
+
+    if (header->op != op)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    client->status = header->status;
+
+    return (header->status == PCA9685_PROTO_STATUS_OK) ? PCA9685LIB_SUCCESS : PCA9685LIB_ERROR;
+}
+
+/* Exported Functions Definitions */
+
+int16_t PCA9685_ClientConnect(PCA9685Client_t *client, const char *socketPath)
+{
+    struct sockaddr_un address; /** Daemon socket address */
+
+    /* Verifying input */
+    if (client == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (socketPath == NULL)
+    {
+        socketPath = PCA9685_PROTO_SOCKET_PATH;
+    }
+
+    if (strlen(socketPath) >= sizeof(address.sun_path))
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socketPath);
+
+    client->status = PCA9685_PROTO_STATUS_OK;
+    client->fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+
+    if (client->fd < 0)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (connect(client->fd, (struct sockaddr *) &address, sizeof(address)) != 0)
+    {
+        close(client->fd);
+        client->fd = -1;
+        return PCA9685LIB_ERROR;
+    }
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_ClientSet(PCA9685Client_t *client, uint16_t i2cDevNumber, uint8_t i2cAddress, 
+                            const PCA9685Frame_t *frame)
+{
+    PCA9685ProtoHeader_t header; /** Request header */
+    PCA9685Frame_t reply; /** Reply channels */
+
+    /* Verifying input */
+    if (client == NULL || client->fd < 0 || frame == NULL || frame->channelMask == 0U)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.op = PCA9685_PROTO_OP_SET;
+    header.i2cAddress = i2cAddress;
+    header.i2cDevNumber = i2cDevNumber;
+    header.channelMask = frame->channelMask;
+
+    return PCA9685ClientRequest(client, &header, frame, &reply);
+}
+
+int16_t PCA9685_ClientGet(PCA9685Client_t *client, uint16_t i2cDevNumber, uint8_t i2cAddress, 
+                            PCA9685Frame_t *frame)
+{
+    PCA9685ProtoHeader_t header; /** Request header */
+
+    /* Verifying input */
+    if (client == NULL || client->fd < 0 || frame == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.op = PCA9685_PROTO_OP_GET;
+    header.i2cAddress = i2cAddress;
+    header.i2cDevNumber = i2cDevNumber;
+    header.channelMask = frame->channelMask;
+
+    return PCA9685ClientRequest(client, &header, NULL, frame);
+}
+
+int16_t PCA9685_ClientSubscribe(PCA9685Client_t *client, uint16_t i2cDevNumber, 
+                                uint8_t i2cAddress, uint16_t channelMask)
+{
+    PCA9685ProtoHeader_t header; /** Request header */
+    PCA9685Frame_t reply; /** Reply channels */
+
+    /* Verifying input */
+    if (client == NULL || client->fd < 0)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.op = PCA9685_PROTO_OP_SUBSCRIBE;
+    header.i2cAddress = i2cAddress;
+    header.i2cDevNumber = i2cDevNumber;
+    header.channelMask = channelMask;
+
+    return PCA9685ClientRequest(client, &header, NULL, &reply);
+}
+
+int16_t PCA9685_ClientSafetyStop(PCA9685Client_t *client, uint16_t i2cDevNumber, 
+                                    uint8_t i2cAddress, uint8_t actions)
+{
+    PCA9685ProtoHeader_t header; /** Request header */
+    PCA9685Frame_t reply; /** Reply channels */
+
+    /* Verifying input */
+    if (client == NULL || client->fd < 0)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.op = PCA9685_PROTO_OP_SAFETY;
+    header.i2cAddress = i2cAddress;
+    header.i2cDevNumber = i2cDevNumber;
+    header.channelMask = actions;
+
+    return PCA9685ClientRequest(client, &header, NULL, &reply);
+}
+
+int16_t PCA9685_ClientResume(PCA9685Client_t *client, uint16_t i2cDevNumber, uint8_t i2cAddress)
+{
+    PCA9685ProtoHeader_t header; /** Request header */
+    PCA9685Frame_t reply; /** Reply channels */
+
+    /* Verifying input */
+    if (client == NULL || client->fd < 0)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.op = PCA9685_PROTO_OP_RESUME;
+    header.i2cAddress = i2cAddress;
+    header.i2cDevNumber = i2cDevNumber;
+
+    return PCA9685ClientRequest(client, &header, NULL, &reply);
+}
+
+int16_t PCA9685_ClientWaitNotify(PCA9685Client_t *client, uint16_t *i2cDevNumber, 
+                                    uint8_t *i2cAddress, PCA9685Frame_t *frame, int timeoutMs)
+{
+    PCA9685ProtoHeader_t header; /** Notification header */
+
+    /* Verifying input */
+    if (client == NULL || client->fd < 0 || i2cDevNumber == NULL || i2cAddress == NULL 
+            || frame == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (PCA9685ClientReceive(client, &header, frame, timeoutMs) != PCA9685LIB_SUCCESS 
+            || header.op != PCA9685_PROTO_OP_NOTIFY)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    *i2cDevNumber = header.i2cDevNumber;
+    *i2cAddress = header.i2cAddress;
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_ClientClose(PCA9685Client_t *client)
+{
+
+    /* Verifying input */
+    if (client == NULL || client->fd < 0)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (close(client->fd) != 0)
+    {
+        client->fd = -1;
+        return PCA9685LIB_ERROR;
+    }
+
+    client->fd = -1;
+
+    return PCA9685LIB_SUCCESS;
+}
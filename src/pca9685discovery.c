@@ -0,0 +1,256 @@
+/*
+MIT License
+
+Copyright (c) 2024 Giuseppe Giglio <g.giglio001@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * \file pca9685discovery.c
+ * \brief This file contains the definitions of the discovery functions, which
+ *       probe every local I2C adapter in parallel for PCA9685 controllers.
+ */
+
+/* Standard library includes */
+#include <glob.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Local includes */
+#include "pca9685discovery.h"
+#include "pca9685lib.h"
+#include "us-i2c.h"
+
+
+/* Unexported macros */
+
+/** Number of addresses in the probed range */
+#define PCA9685_DISCOVERY_ADDRS (PCA9685_DISCOVERY_LAST_ADDR - PCA9685_DISCOVERY_FIRST_ADDR + 1U)
+
+/** Length of the dev path prefix, up to the bus number */
+#define PCA9685_DISCOVERY_DEV_PREFIX_LEN (sizeof(PCA9685_DISCOVERY_DEV_PATTERN) - 2U)
+
+
+/* Unexported typedefs */
+
+/**
+ * \struct PCA9685DiscoveryBus_t
+ * \brief This structure holds a bus being probed and the devices found on it.
+*/
+typedef struct PCA9685DiscoveryBus_s
+{
+    uint16_t i2cDevNumber; /** Linux I2C dev number of the bus */
+    pthread_t thread; /** Probing thread */
+    uint8_t started; /** Non-zero if the probing thread was started */
+    PCA9685Device_t found[PCA9685_DISCOVERY_ADDRS]; /** Devices found */
+    uint32_t foundCount; /** Number of devices found */
+} PCA9685DiscoveryBus_t;
+
+
+/* Unexported functions definitions */
+
+/**
+ * \brief This function tells whether an address is one the PCA9685 answers to
+ *        as a group at power-on, or a reserved address.
+ * \param [in] i2cAddress -- I2C slave address.
+ * \returns Non-zero if the address must not be probed, zero otherwise.
+ */
+uint8_t PCA9685DiscoveryExcluded(uint8_t i2cAddress)
+{
+    return (uint8_t) (i2cAddress == (PCA9685_ALLCALL_ADDR_DEFAULT >> 1U) 
+                        || i2cAddress == (PCA9685_SUBADDR1_DEFAULT >> 1U) 
+                        || i2cAddress == (PCA9685_SUBADDR2_DEFAULT >> 1U) 
+                        || i2cAddress == (PCA9685_SUBADDR3_DEFAULT >> 1U) 
+                        || i2cAddress > PCA9685_DISCOVERY_LAST_ADDR);
+}
+
+/**
+ * \brief This function probes every candidate address of a bus. Addresses with
+ *        no device fail on the address byte, so a miss costs one short
+ *        transaction.
+ * \param [in] argument -- Pointer to the discovery bus.
+ * \returns NULL.
+ */
+void *PCA9685DiscoveryProbe(void *argument)
+{
+    PCA9685DiscoveryBus_t *bus = (PCA9685DiscoveryBus_t *) argument; /** Bus to probe */
+    i2cConfiguration_t i2cConf; /** Bus handle */
+    uint8_t i2cAddress = 0U; /** Probed address */
+    uint8_t mode1 = 0U; /** MODE1 value */
+    uint8_t prescaler = 0U; /** PRE_SCALE value */
+
+    if (i2cInit(bus->i2cDevNumber, &i2cConf) != US_I2C_SUCCESS)
+    {
+        return NULL;
+    }
+
+    for (i2cAddress = PCA9685_DISCOVERY_FIRST_ADDR; i2cAddress <= PCA9685_DISCOVERY_LAST_ADDR; i2cAddress++)
+    {
+        if (PCA9685DiscoveryExcluded(i2cAddress) != 0U)
+        {
+            continue;
+        }
+
+        if (i2cRead(&i2cConf, i2cAddress, 1, PCA9685_MODE1_REG_ADDR, 1, &mode1) != US_I2C_SUCCESS)
+        {
+            continue;
+        }
+
+        /* Other devices in the range are unlikely to hold a valid prescaler there */
+        if (i2cRead(&i2cConf, i2cAddress, 1, PCA9685_PRE_SCALE_REG_ADDR, 1, &prescaler) != US_I2C_SUCCESS 
+                || prescaler < PCA9685_MIN_PRESCALER)
+        {
+            continue;
+        }
+
+        bus->found[bus->foundCount].i2cDevNumber = bus->i2cDevNumber;
+        bus->found[bus->foundCount].i2cAddress = i2cAddress;
+        bus->found[bus->foundCount].mode1 = mode1;
+        bus->found[bus->foundCount].prescaler = prescaler;
+        bus->foundCount++;
+    }
+
+    (void) i2cClose(&i2cConf);
+
+    return NULL;
+}
+
+/**
+ * \brief This function lists the dev numbers of the local I2C adapters.
+ * \param [out] buses -- Discovery buses to fill.
+ * \param [out] busCount -- Number of buses listed.
+ * \returns PCA9685LIB_SUCCESS if the adapters are successfully listed, otherwise PCA9685LIB_ERROR.
+ */
+int16_t PCA9685DiscoveryList(PCA9685DiscoveryBus_t *buses, uint32_t *busCount)
+{
+    glob_t paths; /** Adapter paths */
+    size_t i = 0U; /** Path index */
+    char *end = NULL; /** End of the parsed bus number */
+    unsigned long number = 0U; /** Parsed bus number */
+    int status = 0; /** glob status */
+
+    *busCount = 0U;
+
+    status = glob(PCA9685_DISCOVERY_DEV_PATTERN, 0, NULL, &paths);
+
+    if (status == GLOB_NOMATCH)
+    {
+        return PCA9685LIB_SUCCESS;
+    }
+
+    if (status != 0)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    for (i = 0U; i < paths.gl_pathc && *busCount < PCA9685_DISCOVERY_MAX_BUSES; i++)
+    {
+        number = strtoul(paths.gl_pathv[i] + PCA9685_DISCOVERY_DEV_PREFIX_LEN, &end, 10);
+
+        if (*end == '\0' && end != paths.gl_pathv[i] + PCA9685_DISCOVERY_DEV_PREFIX_LEN 
+                && number <= UINT16_MAX)
+        {
+            buses[*busCount].i2cDevNumber = (uint16_t) number;
+            (*busCount)++;
+        }
+    }
+
+    globfree(&paths);
+
+    return PCA9685LIB_SUCCESS;
+}
+
+
+/* Exported Functions Definitions */
+
+int16_t PCA9685_Discover(const uint16_t *i2cDevNumbers, uint32_t busCount, 
+                            PCA9685Device_t *devices, uint32_t maxDevices, 
+                            uint32_t *deviceCount)
+{
+    PCA9685DiscoveryBus_t *buses = NULL; /** Buses to probe */
+    uint32_t bus = 0U; /** Bus index */
+    uint32_t i = 0U; /** Device index */
+
+    /* Verifying input */
+    if ((devices == NULL && maxDevices != 0U) || deviceCount == NULL 
+            || (i2cDevNumbers != NULL && busCount > PCA9685_DISCOVERY_MAX_BUSES))
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    buses = calloc(PCA9685_DISCOVERY_MAX_BUSES, sizeof(PCA9685DiscoveryBus_t));
+
+    if (buses == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (i2cDevNumbers == NULL)
+    {
+        if (PCA9685DiscoveryList(buses, &busCount) != PCA9685LIB_SUCCESS)
+        {
+            free(buses);
+            return PCA9685LIB_ERROR;
+        }
+    }
+    else
+    {
+        for (bus = 0U; bus < busCount; bus++)
+        {
+            buses[bus].i2cDevNumber = i2cDevNumbers[bus];
+        }
+    }
+
+    for (bus = 0U; bus < busCount; bus++)
+    {
+        buses[bus].started = (uint8_t) (pthread_create(&buses[bus].thread, NULL, 
+                                            PCA9685DiscoveryProbe, &buses[bus]) == 0);
+    }
+
+    *deviceCount = 0U;
+
+    for (bus = 0U; bus < busCount; bus++)
+    {
+        /* Probing inline a bus whose thread could not be started */
+        if (buses[bus].started != 0U)
+        {
+            pthread_join(buses[bus].thread, NULL);
+        }
+        else
+        {
+            (void) PCA9685DiscoveryProbe(&buses[bus]);
+        }
+
+        for (i = 0U; i < buses[bus].foundCount; i++)
+        {
+            if (*deviceCount < maxDevices)
+            {
+                devices[*deviceCount] = buses[bus].found[i];
+            }
+
+            (*deviceCount)++;
+        }
+    }
+
+    free(buses);
+
+    return PCA9685LIB_SUCCESS;
+}
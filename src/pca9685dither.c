@@ -0,0 +1,155 @@
+/*
+MIT License
+
+Copyright (c) 2024 Giuseppe Giglio <g.giglio001@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * \file pca9685dither.c
+ * \brief This file contains the definitions of the temporal dithering stage
+ *       that gives PCA9685 channels more than 12 bits of effective resolution.
+ */
+
+/* Standard library includes */
+#include <stdlib.h>
+#include <string.h>
+
+/* Local includes */
+#include "pca9685dither.h"
+#include "pca9685lib.h"
+
+
+
+/* Exported Functions Definitions */
+
+int16_t PCA9685_DitherInit(PCA9685Dither_t *dither, PCA9685I2CConf_t *board, uint8_t fracBits)
+{
+
+    /* Verifying input */
+    if (dither == NULL || board == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (fracBits < PCA9685_DITHER_MIN_FRAC_BITS || fracBits > PCA9685_DITHER_MAX_FRAC_BITS)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    memset(dither, 0, sizeof(PCA9685Dither_t));
+
+    dither->board = board;
+    dither->fracBits = fracBits;
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_DitherSetLevel(PCA9685Dither_t *dither, uint8_t channel, uint32_t level)
+{
+
+    /* Verifying input */
+    if (dither == NULL || channel >= PCA9685_MAX_PWM_CHANNELS)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (level > ((uint32_t) PCA9685_MAX_PWM_VALUE << dither->fracBits))
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if ((dither->activeMask & (1U << channel)) == 0U)
+    {
+        /* Forcing the first tick to write the channel */
+        dither->residual[channel] = 0U;
+        dither->output[channel] = UINT16_MAX;
+        dither->activeMask |= (uint16_t) (1U << channel);
+    }
+
+    dither->level[channel] = level;
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_DitherRelease(PCA9685Dither_t *dither, uint8_t channel)
+{
+
+    /* Verifying input */
+    if (dither == NULL || channel >= PCA9685_MAX_PWM_CHANNELS)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    dither->activeMask &= (uint16_t) ~(1U << channel);
+    dither->frame.channelMask &= (uint16_t) ~(1U << channel);
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_DitherTick(PCA9685Dither_t *dither)
+{
+    uint32_t fracMask = 0U; /** Mask of the extra resolution bits */
+    uint32_t sum = 0U; /** Level plus accumulated residual */
+    uint16_t active = 0U; /** Channels left to process */
+    uint16_t output = 0U; /** Duty cycle for this tick */
+    uint8_t channel = 0U; /** Channel index */
+
+    /* Verifying input */
+    if (dither == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    fracMask = (1U << dither->fracBits) - 1U;
+    active = dither->activeMask;
+
+    /* First order sigma-delta: the truncated part is carried to the next tick */
+    while (active != 0U)
+    {
+        channel = (uint8_t) __builtin_ctz(active);
+        active &= (uint16_t) (active - 1U);
+
+        sum = dither->level[channel] + dither->residual[channel];
+        output = (uint16_t) (sum >> dither->fracBits);
+        dither->residual[channel] = sum & fracMask;
+
+        if (output != dither->output[channel])
+        {
+            dither->output[channel] = output;
+            (void) PCA9685_FrameSetDuty(&dither->frame, channel, output);
+        }
+    }
+
+    if (dither->frame.channelMask == 0U)
+    {
+        return PCA9685LIB_SUCCESS;
+    }
+
+    if (PCA9685_CommitFrame(dither->board, &dither->frame) != PCA9685LIB_SUCCESS)
+    {
+        /* Pending channels are retried on the next tick */
+        return PCA9685LIB_ERROR;
+    }
+
+    dither->frame.channelMask = 0U;
+
+    return PCA9685LIB_SUCCESS;
+}
@@ -0,0 +1,525 @@
+/*
+MIT License
+
+Copyright (c) 2024 Giuseppe Giglio <g.giglio001@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * \file pca9685engine.c
+ * \brief This file contains the definitions of the multi-bus engine, which
+ *       runs one worker thread per I2C bus so that frames staged for boards on
+ *       different buses are committed in parallel.
+ */
+
+/* CPU affinity interface */
+#define _GNU_SOURCE
+
+/* Standard library includes */
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+/* Local includes */
+#include "pca9685engine.h"
+#include "pca9685lib.h"
+
+
+
+/* Unexported functions definitions */
+
+/**
+ * \brief This function finds the bus of a board.
+ * \param [in] engine -- Pointer to the engine.
+ * \param [in] board -- Pointer to the board configuration data structure.
+ * \param [out] index -- Index of the board on its bus.
+ * \returns Pointer to the bus, NULL if the board was not added.
+ */
+PCA9685EngineBus_t *PCA9685EngineFindBoard(PCA9685Engine_t *engine, 
+                                            const PCA9685I2CConf_t *board, uint32_t *index)
+{
+    uint32_t bus = 0U; /** Bus index */
+    uint32_t i = 0U; /** Board index */
+
+    for (bus = 0U; bus < engine->busCount; bus++)
+    {
+        for (i = 0U; i < engine->buses[bus].boardCount; i++)
+        {
+            if (engine->buses[bus].boards[i] == board)
+            {
+                *index = i;
+                return &engine->buses[bus];
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * \brief This function runs the safety actions of a bus on its boards. Called
+ *        by the bus worker with the engine lock held, which it releases during
+ *        the bus transfers.
+ * \param [in] bus -- Pointer to the engine bus.
+ */
+void PCA9685EngineRunSafety(PCA9685EngineBus_t *bus)
+{
+    PCA9685Engine_t *engine = bus->engine; /** Engine of the bus */
+    uint32_t generation = engine->safetyGeneration; /** Safety generation being run */
+    uint8_t actions = bus->safety; /** Actions to run */
+    uint32_t i = 0U; /** Board index */
+    int16_t status = PCA9685LIB_SUCCESS; /** Actions status */
+
+    __atomic_store_n(&bus->safety, 0U, __ATOMIC_RELAXED);
+
+    pthread_mutex_unlock(&engine->mutex);
+
+    for (i = 0U; i < bus->boardCount; i++)
+    {
+        if (PCA9685_SafetyStop(bus->boards[i], actions) != PCA9685LIB_SUCCESS)
+        {
+            status = PCA9685LIB_ERROR;
+        }
+    }
+
+    pthread_mutex_lock(&engine->mutex);
+
+    bus->safetyStatus = status;
+    bus->safetyCompleted = generation;
+    pthread_cond_broadcast(&engine->done);
+}
+
+/**
+ * \brief This function is the body of a bus worker. Each time a commit is
+ *        requested, it takes the frames staged for its boards and commits them
+ *        outside of the engine lock. Safety actions are run first, and cut a
+ *        commit in progress short.
+ * \param [in] argument -- Pointer to the engine bus.
+ * \returns NULL.
+ */
+void *PCA9685EngineWorker(void *argument)
+{
+    PCA9685EngineBus_t *bus = (PCA9685EngineBus_t *) argument; /** Bus of the worker */
+    PCA9685Engine_t *engine = bus->engine; /** Engine of the bus */
+    PCA9685Frame_t frames[PCA9685_ENGINE_MAX_BOARDS]; /** Frames taken for this commit */
+    PCA9685Frame_t newer; /** Frame staged while the commit ran */
+    uint32_t retained = 0U; /** Boards whose frame was not written */
+    cpu_set_t cpus; /** Worker affinity */
+    uint32_t generation = 0U; /** Commit generation being flushed */
+    uint32_t i = 0U; /** Board index */
+    int16_t status = PCA9685LIB_SUCCESS; /** Flush status */
+
+    if (bus->cpu != PCA9685_ENGINE_NO_CPU)
+    {
+        CPU_ZERO(&cpus);
+        CPU_SET(bus->cpu, &cpus);
+        (void) pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    }
+
+    pthread_mutex_lock(&engine->mutex);
+
+    while (engine->running != 0U)
+    {
+        if (bus->safety != 0U)
+        {
+            PCA9685EngineRunSafety(bus);
+            continue;
+        }
+
+        if (bus->completed == engine->generation)
+        {
+            pthread_cond_wait(&engine->work, &engine->mutex);
+            continue;
+        }
+
+        generation = engine->generation;
+
+        for (i = 0U; i < bus->boardCount; i++)
+        {
+            frames[i] = bus->staged[i];
+            bus->staged[i].channelMask = 0U;
+        }
+
+        pthread_mutex_unlock(&engine->mutex);
+
+        status = PCA9685LIB_SUCCESS;
+        retained = 0U;
+
+        for (i = 0U; i < bus->boardCount; i++)
+        {
+            /* Bulk frames must not be written after a safety stop */
+            if (__atomic_load_n(&bus->safety, __ATOMIC_RELAXED) != 0U)
+            {
+                status = PCA9685LIB_ERROR;
+                break;
+            }
+
+            if (frames[i].channelMask == 0U)
+            {
+                continue;
+            }
+
+            /* A quarantined board is skipped so that it does not hold up the bus */
+            if (PCA9685_IsQuarantined(bus->boards[i]) != 0U 
+                    || PCA9685_CommitFrame(bus->boards[i], &frames[i]) != PCA9685LIB_SUCCESS)
+            {
+                retained |= 1U << i;
+                status = PCA9685LIB_ERROR;
+            }
+        }
+
+        pthread_mutex_lock(&engine->mutex);
+
+        /* Frames not written are kept for the next commit, under the ones staged since */
+        for (i = 0U; i < bus->boardCount; i++)
+        {
+            if ((retained & (1U << i)) != 0U && bus->safety == 0U && engine->stopped == 0U)
+            {
+                newer = bus->staged[i];
+                bus->staged[i] = frames[i];
+                (void) PCA9685_FrameMerge(&bus->staged[i], &newer);
+            }
+        }
+
+        bus->status = status;
+        bus->completed = generation;
+        pthread_cond_broadcast(&engine->done);
+    }
+
+    pthread_mutex_unlock(&engine->mutex);
+
+    return NULL;
+}
+
+/* Exported Functions Definitions */
+
+int16_t PCA9685_EngineInit(PCA9685Engine_t *engine)
+{
+
+    /* Verifying input */
+    if (engine == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    memset(engine, 0, sizeof(PCA9685Engine_t));
+
+    if (pthread_mutex_init(&engine->mutex, NULL) != 0)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (pthread_cond_init(&engine->work, NULL) != 0)
+    {
+        pthread_mutex_destroy(&engine->mutex);
+        return PCA9685LIB_ERROR;
+    }
+
+    if (pthread_cond_init(&engine->done, NULL) != 0)
+    {
+        pthread_cond_destroy(&engine->work);
+        pthread_mutex_destroy(&engine->mutex);
+        return PCA9685LIB_ERROR;
+    }
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_EngineAddBus(PCA9685Engine_t *engine, uint16_t i2cDevNumber, int cpu)
+{
+    PCA9685EngineBus_t *bus = NULL; /** Added bus */
+    uint32_t i = 0U; /** Bus index */
+
+    /* Verifying input */
+    if (engine == NULL || engine->running != 0U || engine->busCount >= PCA9685_ENGINE_MAX_BUSES 
+            || cpu < PCA9685_ENGINE_NO_CPU || cpu >= CPU_SETSIZE)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    for (i = 0U; i < engine->busCount; i++)
+    {
+        if (engine->buses[i].i2cDevNumber == i2cDevNumber)
+        {
+            return PCA9685LIB_ERROR;
+        }
+    }
+
+    bus = &engine->buses[engine->busCount];
+    memset(bus, 0, sizeof(PCA9685EngineBus_t));
+    bus->engine = engine;
+    bus->i2cDevNumber = i2cDevNumber;
+    bus->cpu = cpu;
+    bus->completed = engine->generation;
+    bus->status = PCA9685LIB_SUCCESS;
+    bus->safetyCompleted = engine->safetyGeneration;
+    bus->safetyStatus = PCA9685LIB_SUCCESS;
+
+    engine->busCount++;
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_EngineAddBoard(PCA9685Engine_t *engine, PCA9685I2CConf_t *board)
+{
+    PCA9685EngineBus_t *bus = NULL; /** Bus of the board */
+    uint32_t i = 0U; /** Bus or board index */
+
+    /* Verifying input */
+    if (engine == NULL || board == NULL || engine->running != 0U 
+            || PCA9685EngineFindBoard(engine, board, &i) != NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    for (i = 0U; i < engine->busCount && bus == NULL; i++)
+    {
+        if (engine->buses[i].i2cDevNumber == board->i2cDevNumber)
+        {
+            bus = &engine->buses[i];
+        }
+    }
+
+    if (bus == NULL || bus->boardCount >= PCA9685_ENGINE_MAX_BOARDS)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    bus->boards[bus->boardCount] = board;
+    bus->staged[bus->boardCount].channelMask = 0U;
+    bus->boardCount++;
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_EngineStart(PCA9685Engine_t *engine)
+{
+    uint32_t started = 0U; /** Number of workers started */
+
+    /* Verifying input */
+    if (engine == NULL || engine->running != 0U)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    engine->running = 1U;
+
+    for (started = 0U; started < engine->busCount; started++)
+    {
+        if (pthread_create(&engine->buses[started].worker, NULL, PCA9685EngineWorker, 
+                            &engine->buses[started]) != 0)
+        {
+            break;
+        }
+    }
+
+    if (started < engine->busCount)
+    {
+        pthread_mutex_lock(&engine->mutex);
+        engine->running = 0U;
+        pthread_cond_broadcast(&engine->work);
+        pthread_mutex_unlock(&engine->mutex);
+
+        while (started > 0U)
+        {
+            started--;
+            pthread_join(engine->buses[started].worker, NULL);
+        }
+
+        return PCA9685LIB_ERROR;
+    }
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_EngineStage(PCA9685Engine_t *engine, PCA9685I2CConf_t *board, 
+                            const PCA9685Frame_t *frame)
+{
+    PCA9685EngineBus_t *bus = NULL; /** Bus of the board */
+    uint32_t index = 0U; /** Index of the board on its bus */
+    uint8_t channel = 0U; /** Channel index */
+
+    /* Verifying input */
+    if (engine == NULL || board == NULL || frame == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    for (channel = 0U; channel < PCA9685_MAX_PWM_CHANNELS; channel++)
+    {
+        if ((frame->channelMask & (1U << channel)) != 0U 
+                && (frame->onValue[channel] > PCA9685_MAX_PWM_VALUE 
+                    || frame->offValue[channel] > PCA9685_MAX_PWM_VALUE))
+        {
+            return PCA9685LIB_ERROR;
+        }
+    }
+
+    pthread_mutex_lock(&engine->mutex);
+
+    bus = (engine->stopped == 0U) ? PCA9685EngineFindBoard(engine, board, &index) : NULL;
+
+    if (bus != NULL)
+    {
+        (void) PCA9685_FrameMerge(&bus->staged[index], frame);
+    }
+
+    pthread_mutex_unlock(&engine->mutex);
+
+    return (bus != NULL) ? PCA9685LIB_SUCCESS : PCA9685LIB_ERROR;
+}
+
+int16_t PCA9685_EngineCommitAll(PCA9685Engine_t *engine)
+{
+    uint32_t generation = 0U; /** Commit generation requested */
+    uint32_t i = 0U; /** Bus index */
+    int16_t status = PCA9685LIB_SUCCESS; /** Commit status */
+
+    /* Verifying input */
+    if (engine == NULL || engine->running == 0U)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    pthread_mutex_lock(&engine->mutex);
+
+    generation = ++engine->generation;
+    pthread_cond_broadcast(&engine->work);
+
+    for (i = 0U; i < engine->busCount; i++)
+    {
+        /* A concurrent commit may move the worker past this generation */
+        while (engine->running != 0U 
+                && (int32_t) (engine->buses[i].completed - generation) < 0)
+        {
+            pthread_cond_wait(&engine->done, &engine->mutex);
+        }
+
+        if (engine->buses[i].status != PCA9685LIB_SUCCESS 
+                || (int32_t) (engine->buses[i].completed - generation) < 0)
+        {
+            status = PCA9685LIB_ERROR;
+        }
+    }
+
+    pthread_mutex_unlock(&engine->mutex);
+
+    return status;
+}
+
+int16_t PCA9685_EngineSafetyStop(PCA9685Engine_t *engine, uint8_t actions)
+{
+    uint32_t generation = 0U; /** Safety generation requested */
+    uint32_t i = 0U; /** Bus index */
+    uint32_t board = 0U; /** Board index */
+    int16_t status = PCA9685LIB_SUCCESS; /** Actions status */
+
+    /* Verifying input */
+    if (engine == NULL || engine->running == 0U)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    pthread_mutex_lock(&engine->mutex);
+
+    engine->stopped = 1U;
+    generation = ++engine->safetyGeneration;
+
+    for (i = 0U; i < engine->busCount; i++)
+    {
+        for (board = 0U; board < engine->buses[i].boardCount; board++)
+        {
+            engine->buses[i].staged[board].channelMask = 0U;
+        }
+
+        __atomic_store_n(&engine->buses[i].safety, 
+                            (uint8_t) (engine->buses[i].safety | actions), __ATOMIC_RELAXED);
+    }
+
+    pthread_cond_broadcast(&engine->work);
+
+    for (i = 0U; i < engine->busCount; i++)
+    {
+        while (engine->running != 0U 
+                && (int32_t) (engine->buses[i].safetyCompleted - generation) < 0)
+        {
+            pthread_cond_wait(&engine->done, &engine->mutex);
+        }
+
+        if (engine->buses[i].safetyStatus != PCA9685LIB_SUCCESS 
+                || (int32_t) (engine->buses[i].safetyCompleted - generation) < 0)
+        {
+            status = PCA9685LIB_ERROR;
+        }
+    }
+
+    pthread_mutex_unlock(&engine->mutex);
+
+    return status;
+}
+
+int16_t PCA9685_EngineResume(PCA9685Engine_t *engine)
+{
+
+    /* Verifying input */
+    if (engine == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    pthread_mutex_lock(&engine->mutex);
+    engine->stopped = 0U;
+    pthread_mutex_unlock(&engine->mutex);
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_EngineStop(PCA9685Engine_t *engine)
+{
+    uint32_t i = 0U; /** Bus index */
+    uint32_t board = 0U; /** Board index */
+
+    /* Verifying input */
+    if (engine == NULL || engine->running == 0U)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    pthread_mutex_lock(&engine->mutex);
+    engine->running = 0U;
+    pthread_cond_broadcast(&engine->work);
+    pthread_cond_broadcast(&engine->done);
+    pthread_mutex_unlock(&engine->mutex);
+
+    for (i = 0U; i < engine->busCount; i++)
+    {
+        pthread_join(engine->buses[i].worker, NULL);
+
+        for (board = 0U; board < engine->buses[i].boardCount; board++)
+        {
+            engine->buses[i].staged[board].channelMask = 0U;
+        }
+
+        /* Requests made meanwhile are not pending after a restart */
+        engine->buses[i].completed = engine->generation;
+    }
+
+    return PCA9685LIB_SUCCESS;
+}
@@ -29,16 +29,390 @@ SOFTWARE.
  */
 
 /* Standard library includes */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c-dev.h>
 
 /* Local includes */
 #include "pca9685lib.h"
+#include "pca9685buslock.h"
+#include "pca9685seqlock.h"
 #include "us-i2c.h"
 
 
+/* Unexported macros */
+
+/** Maximum number of spans produced by the planner (one every other register) */
+#define PCA9685_MAX_SPANS (PCA9685_LED_REGS_SIZE / 2U)
+
+/** Unit of the I2C_TIMEOUT ioctl */
+#define PCA9685_I2C_TIMEOUT_UNIT_MS (10U)
+
+/** Registers from MODE1 up to LED15_OFF_H, written by a single restore burst */
+#define PCA9685_CONFIG_REGS_SIZE ((uint8_t) (PCA9685_LED15_OFF_H_REG_ADDR + 1U))
+
+
+/* Unexported typedefs */
+
+/**
+ * \struct PCA9685Span_t
+ * \brief This structure describes a run of consecutive LEDn registers.
+*/
+typedef struct PCA9685Span_s
+{
+    uint8_t offset; /** Offset of the first register from LED0_ON_L */
+    uint8_t length; /** Number of registers */
+} PCA9685Span_t;
+
 
 /* Unexported functions definitions */
 
+/**
+ * \brief This function adds a transaction measurement to the running sums of
+ *        an estimator and refits the bus cost model from them.
+ * \param [in,out] est -- The estimator.
+ * \param [in,out] busCost -- The bus cost model, replaced when refitted.
+ * \param [in] length -- Number of bytes of the transaction.
+ * \param [in] elapsedNs -- Measured duration of the transaction.
+ */
+void PCA9685CostFit(PCA9685CostEstimator_t *est, PCA9685BusCost_t *busCost, 
+                    uint16_t length, uint64_t elapsedNs)
+{
+    double x = (double) length; /** Sample length */
+    double y = (double) elapsedNs; /** Sample duration */
+    double det = 0.0; /** Regression determinant */
+    double slope = 0.0; /** Fitted cost per byte */
+    double intercept = 0.0; /** Fitted cost per transaction */
+
+    /* Dropping samples inflated by scheduling rather than by the bus */
+    if (est->samples >= PCA9685_COST_MIN_SAMPLES
+            && elapsedNs > PCA9685_COST_OUTLIER_RATIO 
+                * ((uint64_t) busCost->transactionNs + ((uint64_t) length * busCost->byteNs)))
+    {
+        return;
+    }
+
+    est->sumW = (est->sumW * PCA9685_COST_FORGET_FACTOR) + 1.0;
+    est->sumX = (est->sumX * PCA9685_COST_FORGET_FACTOR) + x;
+    est->sumY = (est->sumY * PCA9685_COST_FORGET_FACTOR) + y;
+    est->sumXX = (est->sumXX * PCA9685_COST_FORGET_FACTOR) + (x * x);
+    est->sumXY = (est->sumXY * PCA9685_COST_FORGET_FACTOR) + (x * y);
+    est->samples++;
+
+    if (est->samples < PCA9685_COST_MIN_SAMPLES)
+    {
+        return;
+    }
+
+    /* Slope is only meaningful once different lengths have been seen */
+    det = (est->sumW * est->sumXX) - (est->sumX * est->sumX);
+
+    if (det < (0.25 * est->sumW * est->sumW))
+    {
+        return;
+    }
+
+    slope = ((est->sumW * est->sumXY) - (est->sumX * est->sumY)) / det;
+    intercept = (est->sumY - (slope * est->sumX)) / est->sumW;
+
+    busCost->byteNs = (slope > 0.0) ? (uint32_t) slope : 0U;
+    busCost->transactionNs = (intercept > 0.0) ? (uint32_t) intercept : 0U;
+
+    est->busCost = *busCost;
+    est->fitted = 1U;
+}
+
+/**
+ * \brief This function feeds a transaction measurement to the estimator of the
+ *        bus, shared by its handles, and refits the bus cost model.
+ * \param [in] controllerConf -- The configuration of the PCA9685 controller.
+ * \param [in] length -- Number of bytes of the transaction.
+ * \param [in] elapsedNs -- Measured duration of the transaction.
+ */
+void PCA9685CostSample(PCA9685I2CConf_t *controllerConf, uint16_t length, uint64_t elapsedNs)
+{
+    PCA9685CostEstimator_t *est = NULL; /** Estimator of the bus */
+
+    est = PCA9685BusEstimatorAcquire(controllerConf->costEstimator);
+
+    /* Other handles of the bus may have refitted the model meanwhile */
+    if (est->fitted != 0U)
+    {
+        controllerConf->busCost = est->busCost;
+    }
+
+    PCA9685CostFit(est, &controllerConf->busCost, length, elapsedNs);
+
+    PCA9685BusEstimatorRelease(controllerConf->costEstimator);
+}
+
+/**
+ * \brief This function takes the bus lock of a thread-safe handle. Sequences
+ *        that must not interleave with other threads are run under the lock,
+ *        which is recursive.
+ * \param [in] controllerConf -- The configuration of the PCA9685 controller.
+ */
+void PCA9685Lock(PCA9685I2CConf_t *controllerConf)
+{
+    if (controllerConf->busLock != NULL)
+    {
+        PCA9685BusLockAcquire(controllerConf->busLock);
+    }
+}
+
+/**
+ * \brief This function releases the bus lock taken with PCA9685Lock.
+ * \param [in] controllerConf -- The configuration of the PCA9685 controller.
+ */
+void PCA9685Unlock(PCA9685I2CConf_t *controllerConf)
+{
+    if (controllerConf->busLock != NULL)
+    {
+        PCA9685BusLockRelease(controllerConf->busLock);
+    }
+}
+
+/**
+ * \brief This function updates the health of the controller with the outcome
+ *        of a transaction. A failure while quarantined only extends the
+ *        quarantine once its retry time has come, so that the transactions of a
+ *        single retry do not escalate the backoff more than once.
+ * \param [in] controllerConf -- The configuration of the PCA9685 controller.
+ * \param [in] status -- Transaction status.
+ */
+void PCA9685HealthUpdate(PCA9685I2CConf_t *controllerConf, int16_t status)
+{
+    PCA9685Health_t *health = &controllerConf->health; /** Controller health */
+    uint64_t now = 0U; /** Current time */
+
+    if (status == PCA9685LIB_SUCCESS)
+    {
+        health->consecutiveFailures = 0U;
+        health->backoffMs = 0U;
+        return;
+    }
+
+    health->failures++;
+    health->consecutiveFailures++;
+
+    if (health->consecutiveFailures < PCA9685_HEALTH_FAIL_THRESHOLD)
+    {
+        return;
+    }
+
+    now = PCA9685MonotonicNs();
+
+    if (health->backoffMs == 0U)
+    {
+        health->backoffMs = PCA9685_HEALTH_MIN_BACKOFF_MS;
+    }
+    else if (now >= health->retryAtNs)
+    {
+        health->backoffMs = (health->backoffMs * 2U < PCA9685_HEALTH_MAX_BACKOFF_MS) 
+                                ? health->backoffMs * 2U : PCA9685_HEALTH_MAX_BACKOFF_MS;
+    }
+    else
+    {
+        return;
+    }
+
+    health->retryAtNs = now + ((uint64_t) health->backoffMs * 1000000U);
+    health->quarantines++;
+}
+
+/**
+ * \brief This function maps an errno reported by the I2C library to an error
+ *        class, following the Linux I2C fault codes.
+ * \param [in] errnum -- errno value.
+ * \returns The PCA9685_ERR_* class.
+ */
+int16_t PCA9685ErrorClass(int errnum)
+{
+    switch (errnum)
+    {
+        case ENXIO:
+        case EREMOTEIO:
+        case ENODEV:
+            return PCA9685_ERR_NO_ACK;
+        case EAGAIN:
+            return PCA9685_ERR_ARBITRATION;
+        case EBUSY:
+            return PCA9685_ERR_BUS_BUSY;
+        case ETIMEDOUT:
+            return PCA9685_ERR_TIMEOUT;
+        case EIO:
+        case EPROTO:
+        case EBADMSG:
+            return PCA9685_ERR_PROTOCOL;
+        default:
+            return PCA9685_ERR_ADAPTER;
+    }
+}
+
+/**
+ * \brief This function records a failed transaction in the last error slot and
+ *        tells whether the retry policy allows another attempt, waiting for the
+ *        retry delay if it does.
+ * \param [in] controllerConf -- The configuration of the PCA9685 controller.
+ * \param [in] op -- PCA9685_OP_* operation.
+ * \param [in] reg -- First register of the transaction.
+ * \param [in] length -- Number of bytes of the transaction.
+ * \param [in] errnum -- errno reported by the I2C library.
+ * \param [in] attempts -- Attempts made so far.
+ * \returns Non-zero if the transaction must be attempted again, zero otherwise.
+ */
+uint8_t PCA9685TransferFailed(PCA9685I2CConf_t *controllerConf, uint8_t op, uint8_t reg, 
+                                uint8_t length, int errnum, uint8_t attempts)
+{
+    const PCA9685RetryPolicy_t *policy = &controllerConf->retryPolicy; /** Retry policy */
+    PCA9685Error_t *error = &controllerConf->lastError; /** Last error slot */
+    struct timespec delay; /** Retry delay */
+
+    error->code = PCA9685ErrorClass(errnum);
+    error->op = op;
+    error->reg = reg;
+    error->length = length;
+    error->attempts = attempts;
+    error->errnum = errnum;
+
+    /* Permanent errors would fail again, retrying only wastes bus time */
+    if (attempts > policy->maxRetries || (policy->retryMask & (1U << error->code)) == 0U)
+    {
+        return 0U;
+    }
+
+    if (policy->delayUs != 0U)
+    {
+        delay.tv_sec = (time_t) (policy->delayUs / 1000000U);
+        delay.tv_nsec = (long) ((policy->delayUs % 1000000U) * 1000U);
+        (void) clock_nanosleep(CLOCK_MONOTONIC, 0, &delay, NULL);
+    }
+
+    return 1U;
+}
+
+/**
+ * \brief This function writes consecutive registers through the I2C library,
+ *        measuring the transaction for the bus cost model. Failures are
+ *        recorded in the last error slot and retried as the retry policy allows.
+ * \param [in] controllerConf -- The configuration of the PCA9685 controller.
+ * \param [in] reg -- The first register to write to.
+ * \param [in] length -- The number of bytes to write.
+ * \param [in] data -- The data to write.
+ * \returns PCA9685LIB_SUCCESS if the transaction is successful, otherwise
+ *          PCA9685LIB_ERROR.
+ */
+int16_t PCA9685I2CWrite(PCA9685I2CConf_t *controllerConf, uint8_t reg, 
+                        uint8_t length, uint8_t *data)
+{
+    uint64_t start = 0U; /** Transaction start time */
+    uint8_t attempts = 0U; /** Attempts made */
+    int errnum = 0; /** errno of the failed attempt */
+    int16_t status = PCA9685LIB_SUCCESS; /** Transaction status */
+
+    /* Transactions of thread-safe handles on the same bus never overlap */
+    PCA9685Lock(controllerConf);
+
+    do
+    {
+        attempts++;
+
+        if (controllerConf->costCalibration != 0U)
+        {
+            start = PCA9685MonotonicNs();
+        }
+
+        if (i2cWrite(&controllerConf->i2cConf, controllerConf->i2cAddr, 
+                        1, reg, length, data) != US_I2C_SUCCESS)
+        {
+            errnum = errno;
+            status = PCA9685LIB_ERROR;
+        }
+        else
+        {
+            status = PCA9685LIB_SUCCESS;
+
+            if (controllerConf->costCalibration != 0U)
+            {
+                /* Register address byte plus payload */
+                PCA9685CostSample(controllerConf, (uint16_t) (length + 1U), PCA9685MonotonicNs() - start);
+            }
+        }
+    } while (status != PCA9685LIB_SUCCESS 
+                && PCA9685TransferFailed(controllerConf, PCA9685_OP_WRITE, reg, length, 
+                                            errnum, attempts) != 0U);
+
+    PCA9685HealthUpdate(controllerConf, status);
+
+    PCA9685Unlock(controllerConf);
+
+    return status;
+}
+
+/**
+ * \brief This function reads consecutive registers through the I2C library,
+ *        measuring the transaction for the bus cost model. Failures are
+ *        recorded in the last error slot and retried as the retry policy allows.
+ * \param [in] controllerConf -- The configuration of the PCA9685 controller.
+ * \param [in] reg -- The first register to read from.
+ * \param [in] length -- The number of bytes to read.
+ * \param [out] data -- The data read.
+ * \returns PCA9685LIB_SUCCESS if the transaction is successful, otherwise
+ *          PCA9685LIB_ERROR.
+ */
+int16_t PCA9685I2CRead(PCA9685I2CConf_t *controllerConf, uint8_t reg, 
+                        uint8_t length, uint8_t *data)
+{
+    uint64_t start = 0U; /** Transaction start time */
+    uint8_t attempts = 0U; /** Attempts made */
+    int errnum = 0; /** errno of the failed attempt */
+    int16_t status = PCA9685LIB_SUCCESS; /** Transaction status */
+
+    /* Transactions of thread-safe handles on the same bus never overlap */
+    PCA9685Lock(controllerConf);
+
+    do
+    {
+        attempts++;
+
+        if (controllerConf->costCalibration != 0U)
+        {
+            start = PCA9685MonotonicNs();
+        }
+
+        if (i2cRead(&controllerConf->i2cConf, controllerConf->i2cAddr, 
+                        1, reg, length, data) != US_I2C_SUCCESS)
+        {
+            errnum = errno;
+            status = PCA9685LIB_ERROR;
+        }
+        else
+        {
+            status = PCA9685LIB_SUCCESS;
+
+            if (controllerConf->costCalibration != 0U)
+            {
+                /* Register address, repeated start address byte and payload */
+                PCA9685CostSample(controllerConf, (uint16_t) (length + 2U), PCA9685MonotonicNs() - start);
+            }
+        }
+    } while (status != PCA9685LIB_SUCCESS 
+                && PCA9685TransferFailed(controllerConf, PCA9685_OP_READ, reg, length, 
+                                            errnum, attempts) != 0U);
+
+    PCA9685HealthUpdate(controllerConf, status);
+
+    PCA9685Unlock(controllerConf);
+
+    return status;
+}
+
 /**
  * \brief This function is used to write a byte to a register of the PCA9685.
  * \param [in] controllerConf -- The configuration of the PCA9685 controller.
@@ -65,8 +439,7 @@ int16_t PCA9685WriteReg(PCA9685I2CConf_t *controllerConf, uint8_t reg, uint8_t d
     }
 
     /* Writing data to the register */
-    if (i2cWrite(&controllerConf->i2cConf, controllerConf->i2cAddr, 
-                    1, reg, 1, &data) != US_I2C_SUCCESS)
+    if (PCA9685I2CWrite(controllerConf, reg, 1U, &data) != PCA9685LIB_SUCCESS)
     {
         return PCA9685LIB_ERROR;
     }
@@ -100,8 +473,7 @@ int16_t PCA9685ReadReg(PCA9685I2CConf_t *controllerConf, uint8_t reg, uint8_t *d
     }
 
     /* Reading data from the register */
-    if (i2cRead(&controllerConf->i2cConf, controllerConf->i2cAddr, 
-                    1, reg, 1, data) != US_I2C_SUCCESS)
+    if (PCA9685I2CRead(controllerConf, reg, 1U, data) != PCA9685LIB_SUCCESS)
     {
         return PCA9685LIB_ERROR;
     }
@@ -109,123 +481,1754 @@ int16_t PCA9685ReadReg(PCA9685I2CConf_t *controllerConf, uint8_t reg, uint8_t *d
     return PCA9685LIB_SUCCESS;
 }
 
-/* Exported Functions Definitions */
+/**
+ * \brief This function waits for the oscillator to be stable after SLEEP is
+ *        cleared. An absolute deadline keeps the wait accurate when it is
+ *        interrupted by signals.
+ * \param [in] wakeNs -- Monotonic time at which SLEEP was cleared, in nanoseconds.
+ */
+void PCA9685OscillatorWait(uint64_t wakeNs)
+{
+    uint64_t deadlineNs = wakeNs + (PCA9685_OSC_STARTUP_US * 1000U); /** End of the wait */
+    struct timespec deadline; /** End of the wait, as timespec */
 
-int16_t PCA9685_Init(PCA9685I2CConf_t *controllerConf, uint8_t i2cAddress, 
-                        uint16_t i2cDevNumber)
+    deadline.tv_sec = (time_t) (deadlineNs / 1000000000U);
+    deadline.tv_nsec = (long) (deadlineNs % 1000000000U);
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) != 0)
+    {
+        if (PCA9685MonotonicNs() >= deadlineNs)
+        {
+            break;
+        }
+    }
+}
+
+/**
+ * \brief This function records a value written to MODE1 or MODE2, so that a
+ *        lost state can be detected and restored. Other registers are ignored.
+ * \param [in] controllerConf -- The configuration of the PCA9685 controller.
+ * \param [in] reg -- The register written.
+ * \param [in] value -- The value written.
+ */
+void PCA9685ModeShadowStore(PCA9685I2CConf_t *controllerConf, uint8_t reg, uint8_t value)
 {
-    
-    /* Verifying input */
-    
-    if (controllerConf == NULL)
+    PCA9685Mode1Reg_u mode1 = {0U}; /** MODE1 value */
+
+    if (reg == PCA9685_MODE1_REG_ADDR)
     {
-        return PCA9685LIB_ERROR;
+        /* RESTART is a one-shot command, not part of the configuration */
+        mode1.regValue = value;
+        mode1.bitfield.restart = 0;
+
+        controllerConf->autoIncrement = mode1.bitfield.ai;
+        controllerConf->mode1Shadow = mode1.regValue;
+        controllerConf->modeShadowValid |= PCA9685_MODE1_SHADOW_VALID;
     }
+    else if (reg == PCA9685_MODE2_REG_ADDR)
+    {
+        controllerConf->mode2Shadow = value;
+        controllerConf->modeShadowValid |= PCA9685_MODE2_SHADOW_VALID;
+    }
+}
 
-    /* Opening I2C channel towards PCA9685 */
-    if (i2cInit(i2cDevNumber, &controllerConf->i2cConf) != US_I2C_SUCCESS)
+/**
+ * \brief This function is used to change some bits of a register of the PCA9685
+ *        in a single read-modify-write sequence, run under the bus lock.
+ * \param [in] controllerConf -- The configuration of the PCA9685 controller.
+ * \param [in] reg -- The register to modify.
+ * \param [in] clearBits -- The bits to clear.
+ * \param [in] setBits -- The bits to set.
+ * \returns PCA9685LIB_SUCCESS if the register is successfully modified, otherwise
+ *          PCA9685LIB_ERROR.
+ */
+int16_t PCA9685ModifyReg(PCA9685I2CConf_t *controllerConf, uint8_t reg, 
+                            uint8_t clearBits, uint8_t setBits)
+{
+    PCA9685Mode1Reg_u regValue = {0U}; /** Register value */
+    int16_t status = PCA9685LIB_ERROR; /** Sequence status */
+
+    PCA9685Lock(controllerConf);
+
+    /* Reading register first */
+    if (PCA9685ReadReg(controllerConf, reg, &regValue.regValue) == PCA9685LIB_SUCCESS)
     {
-        return PCA9685LIB_ERROR;
+        /* RESTART reads back set while a restart is pending, writing it back
+           would restart the PWM channels before the oscillator is stable */
+        if (reg == PCA9685_MODE1_REG_ADDR)
+        {
+            regValue.bitfield.restart = 0;
+        }
+
+        regValue.regValue = (uint8_t) ((regValue.regValue & ~clearBits) | setBits);
+
+        status = PCA9685WriteReg(controllerConf, reg, regValue.regValue);
+
+        if (status == PCA9685LIB_SUCCESS)
+        {
+            PCA9685ModeShadowStore(controllerConf, reg, regValue.regValue);
+        }
     }
 
-    /* Setting PCA9685 I2C address */
-    controllerConf->i2cAddr = i2cAddress;
+    PCA9685Unlock(controllerConf);
 
-    return PCA9685LIB_SUCCESS;
+    return status;
 }
 
-int16_t PCA9685_GetMode1Reg(PCA9685I2CConf_t *controllerConf, PCA9685Mode1Reg_u *modeReg)
+/**
+ * \brief This function makes sure the MODE1 AI bit is set, so that
+ *        multi-byte transactions address consecutive registers.
+ * \param [in] controllerConf -- The configuration of the PCA9685 controller.
+ * \returns PCA9685LIB_SUCCESS if auto increment is enabled, otherwise
+ *          PCA9685LIB_ERROR.
+ */
+int16_t PCA9685EnableAutoIncrement(PCA9685I2CConf_t *controllerConf)
 {
-    
-    /* Verifying input */
-    if (controllerConf == NULL || modeReg == NULL)
+    PCA9685Mode1Reg_u setBits = {0U}; /** MODE1 bits to set */
+    PCA9685Mode1Reg_u clearBits = {0U}; /** MODE1 bits to clear */
+
+    if (controllerConf->autoIncrement != 0U)
     {
-        return PCA9685LIB_ERROR;
+        return PCA9685LIB_SUCCESS;
     }
 
-    /* Reading mode 1 reg */
-    if (PCA9685ReadReg(controllerConf, PCA9685_MODE1_REG_ADDR, (uint8_t *) &modeReg->regValue) != PCA9685LIB_SUCCESS)
+    /** Setting AI bit, without triggering a restart */
+    setBits.bitfield.ai = 1;
+    clearBits.bitfield.restart = 1;
+
+    return PCA9685ModifyReg(controllerConf, PCA9685_MODE1_REG_ADDR, 
+                            clearBits.regValue, setBits.regValue);
+}
+
+/**
+ * \brief This function is used to read consecutive registers of the PCA9685
+ *        in a single auto-increment transaction.
+ * \param [in] controllerConf -- The configuration of the PCA9685 controller.
+ * \param [in] reg -- The first register to read from.
+ * \param [in] length -- The number of bytes to read.
+ * \param [out] data -- The data read from the registers.
+ * \returns PCA9685LIB_SUCCESS if the read operation is successful, otherwise
+ *          PCA9685LIB_ERROR.
+ */
+int16_t PCA9685ReadBurst(PCA9685I2CConf_t *controllerConf, uint8_t reg, 
+                            uint8_t length, uint8_t *data)
+{
+    int16_t status = PCA9685LIB_ERROR; /** Sequence status */
+
+    PCA9685Lock(controllerConf);
+
+    if (PCA9685EnableAutoIncrement(controllerConf) == PCA9685LIB_SUCCESS)
     {
-        return PCA9685LIB_ERROR;
+        status = PCA9685I2CRead(controllerConf, reg, length, data);
     }
 
-    return PCA9685LIB_SUCCESS;
+    PCA9685Unlock(controllerConf);
+
+    return status;
 }
 
-int16_t PCA9685_SetMode1Reg(PCA9685I2CConf_t *controllerConf, PCA9685Mode1Reg_u modeReg)
+/**
+ * \brief This function is used to write consecutive registers of the PCA9685
+ *        in a single auto-increment transaction.
+ * \param [in] controllerConf -- The configuration of the PCA9685 controller.
+ * \param [in] reg -- The first register to write to.
+ * \param [in] length -- The number of bytes to write.
+ * \param [in] data -- The data to write to the registers.
+ * \returns PCA9685LIB_SUCCESS if the write operation is successful, otherwise
+ *          PCA9685LIB_ERROR.
+ */
+int16_t PCA9685WriteBurst(PCA9685I2CConf_t *controllerConf, uint8_t reg, 
+                            uint8_t length, uint8_t *data)
 {
 
     /* Verifying input */
-    if (controllerConf == NULL)
+
+    if (controllerConf == NULL || data == NULL || length == 0U)
     {
         return PCA9685LIB_ERROR;
     }
 
-    /* Writing mode 1 reg */
-    if (PCA9685WriteReg(controllerConf, PCA9685_MODE1_REG_ADDR, modeReg.regValue) != PCA9685LIB_SUCCESS)
+    /* Verifying requested span stays inside one register bank. */
+    if (!((reg + length - 1U) <= PCA9685_LED15_OFF_H_REG_ADDR
+            || (reg >= PCA9685_ALL_LED_ON_L_REG_ADDR && (reg + length - 1U) <= PCA9685_PRE_SCALE_REG_ADDR)))
     {
         return PCA9685LIB_ERROR;
     }
 
+    PCA9685Lock(controllerConf);
+
+    /* Writing data to the registers */
+    if (PCA9685EnableAutoIncrement(controllerConf) != PCA9685LIB_SUCCESS 
+            || PCA9685I2CWrite(controllerConf, reg, length, data) != PCA9685LIB_SUCCESS)
+    {
+        PCA9685Unlock(controllerConf);
+        return PCA9685LIB_ERROR;
+    }
+
+    PCA9685Unlock(controllerConf);
+
     return PCA9685LIB_SUCCESS;
 }
 
-int16_t PCA9685_GetMode2Reg(PCA9685I2CConf_t *controllerConf, PCA9685Mode2Reg_u *modeReg)
+/**
+ * \brief This function stores a channel ON/OFF pair in the shadow copy.
+ *        Must be called inside a shadowSeq write section.
+ * \param [in] controllerConf -- The configuration of the PCA9685 controller.
+ * \param [in] channel -- PWM channel number.
+ * \param [in] onValue -- ON value.
+ * \param [in] offValue -- OFF value.
+ */
+void PCA9685ShadowStore(PCA9685I2CConf_t *controllerConf, uint8_t channel, 
+                            uint16_t onValue, uint16_t offValue)
 {
-    
-    /* Verifying input */
-    if (controllerConf == NULL || modeReg == NULL)
+    uint8_t *shadow = &controllerConf->ledShadow[channel * 4U]; /** Channel shadow registers */
+
+    shadow[0] = (uint8_t) onValue;
+    shadow[1] = (uint8_t) (onValue >> 8U);
+    shadow[2] = (uint8_t) offValue;
+    shadow[3] = (uint8_t) (offValue >> 8U);
+
+    controllerConf->shadowValid |= (uint16_t) (1U << channel);
+}
+
+/**
+ * \brief This function expands a channel bitmask to a LEDn register bitmask.
+ * \param [in] channelMask -- Bitmask of channels.
+ * \returns Bitmask with the four register bits of each channel set.
+ */
+uint64_t PCA9685ChannelsToRegs(uint16_t channelMask)
+{
+    uint64_t regMask = 0U; /** Register bitmask */
+    uint8_t channel = 0U; /** Channel index */
+
+    for (channel = 0U; channel < PCA9685_MAX_PWM_CHANNELS; channel++)
+    {
+        if ((channelMask & (1U << channel)) != 0U)
+        {
+            regMask |= (uint64_t) 0xFU << (channel * 4U);
+        }
+    }
+
+    return regMask;
+}
+
+/**
+ * \brief This function groups dirty LEDn registers into write spans.
+ *        Runs of dirty registers are scanned from the bitmask and two adjacent
+ *        runs are merged when rewriting the clean registers in between costs
+ *        less than the overhead of a new transaction. Since the cost is linear,
+ *        deciding each gap on its own gives the cheapest plan.
+ * \param [in] busCost -- Bus cost model.
+ * \param [in] dirty -- Bitmask of registers to write.
+ * \param [in] known -- Bitmask of registers whose value may be rewritten.
+ * \param [out] spans -- Array of at least PCA9685_MAX_SPANS spans.
+ * \returns The number of spans written to spans.
+ */
+uint8_t PCA9685PlanSpans(const PCA9685BusCost_t *busCost, uint64_t dirty, 
+                            uint64_t known, PCA9685Span_t *spans)
+{
+    uint8_t spanCount = 0U; /** Number of planned spans */
+    uint8_t start = 0U; /** Offset of the current run */
+    uint8_t end = 0U; /** Offset past the current run */
+    uint64_t clean = 0U; /** Clean registers from the current run onwards */
+
+    while (dirty != 0U)
+    {
+        start = (uint8_t) __builtin_ctzll(dirty);
+        clean = ~dirty & (~(uint64_t) 0U << start);
+        end = (clean != 0U) ? (uint8_t) __builtin_ctzll(clean) : 64U;
+
+        dirty = (end == 64U) ? 0U : (dirty & (~(uint64_t) 0U << end));
+
+        if (spanCount > 0U)
+        {
+            PCA9685Span_t *prev = &spans[spanCount - 1U]; /** Previous span */
+            uint8_t gap = start - (prev->offset + prev->length); /** Clean registers in between */
+            uint64_t gapMask = (((uint64_t) 1U << gap) - 1U) << (prev->offset + prev->length); /** Registers in between */
+
+            /* Merging saves one transaction and one register address byte */
+            if ((gapMask & ~known) == 0U 
+                    && ((uint64_t) gap * busCost->byteNs) 
+                        <= ((uint64_t) busCost->transactionNs + busCost->byteNs))
+            {
+                prev->length = end - prev->offset;
+                continue;
+            }
+        }
+
+        spans[spanCount].offset = start;
+        spans[spanCount].length = end - start;
+        spanCount++;
+    }
+
+    return spanCount;
+}
+
+/**
+ * \brief This function computes the bus cost of a set of spans.
+ * \param [in] busCost -- Bus cost model.
+ * \param [in] spans -- Array of spans.
+ * \param [in] spanCount -- Number of spans.
+ * \returns The estimated cost, in nanoseconds.
+ */
+uint64_t PCA9685SpansCost(const PCA9685BusCost_t *busCost, const PCA9685Span_t *spans, 
+                            uint8_t spanCount)
+{
+    uint64_t cost = 0U; /** Accumulated cost */
+    uint8_t span = 0U; /** Span index */
+
+    for (span = 0U; span < spanCount; span++)
+    {
+        /* Register address byte plus payload */
+        cost += busCost->transactionNs 
+                + ((uint64_t) (spans[span].length + 1U) * busCost->byteNs);
+    }
+
+    return cost;
+}
+
+/**
+ * \brief This function decodes the duty cycle of a channel from its registers.
+ * \param [in] regs -- LEDn ON_L, ON_H, OFF_L and OFF_H values.
+ * \returns The duty cycle, from 0 to PCA9685_MAX_PWM_VALUE.
+ */
+int32_t PCA9685RegsToDuty(const uint8_t *regs)
+{
+    uint16_t onValue = (uint16_t) (regs[0] | (regs[1] << 8U)); /** ON value */
+    uint16_t offValue = (uint16_t) (regs[2] | (regs[3] << 8U)); /** OFF value */
+
+    /* Full OFF takes precedence over full ON */
+    if ((offValue & PCA9685_MAX_PWM_VALUE) != 0U)
+    {
+        return 0;
+    }
+
+    if ((onValue & PCA9685_MAX_PWM_VALUE) != 0U)
+    {
+        return PCA9685_MAX_PWM_VALUE;
+    }
+
+    return (int32_t) ((offValue - onValue) & (PCA9685_MAX_PWM_VALUE - 1U));
+}
+
+/**
+ * \brief This function records an LEDn registers write and wakes the controller
+ *        up if auto-sleep put it to sleep and the write turns a channel on.
+ *        Must be called under the bus lock, before the write.
+ * \param [in] controllerConf -- The configuration of the PCA9685 controller.
+ * \param [in] active -- Non-zero if the write leaves a channel with a non-zero duty cycle.
+ * \returns PCA9685LIB_SUCCESS if the controller is ready for the write, otherwise PCA9685LIB_ERROR.
+ */
+int16_t PCA9685AutoWake(PCA9685I2CConf_t *controllerConf, uint8_t active)
+{
+    PCA9685Mode1Reg_u mode1 = {0U}; /** MODE1 value */
+
+    if (controllerConf->autoSleepMs == 0U)
+    {
+        return PCA9685LIB_SUCCESS;
+    }
+
+    controllerConf->lastWriteNs = PCA9685MonotonicNs();
+
+    if (active == 0U || controllerConf->autoSlept == 0U)
+    {
+        return PCA9685LIB_SUCCESS;
+    }
+
+    /* Woken up by the application meanwhile */
+    mode1.regValue = controllerConf->mode1Shadow;
+
+    if (mode1.bitfield.sleep != 0U 
+            && PCA9685_FastResume(controllerConf) != PCA9685LIB_SUCCESS)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    controllerConf->autoSlept = 0U;
+
+    return PCA9685LIB_SUCCESS;
+}
+
+/**
+ * \brief This function writes a frame, planning the transactions from the
+ *        shadow copy and the bus cost model.
+ * \param [in] controllerConf -- The configuration of the PCA9685 controller.
+ * \param [in] frame -- The frame to write.
+ * \returns PCA9685LIB_SUCCESS if the frame is successfully written, otherwise
+ *          PCA9685LIB_ERROR.
+ */
+int16_t PCA9685WriteFrame(PCA9685I2CConf_t *controllerConf, const PCA9685Frame_t *frame)
+{
+    uint8_t target[PCA9685_LED_REGS_SIZE] = {0U}; /** Board LED registers after commit */
+    uint16_t targetValid = 0U; /** Channels whose value is known after commit */
+    uint64_t dirty = 0U; /** Registers that differ from the shadow copy */
+    uint8_t uniform = 1U; /** Non-zero if every channel holds the same ON/OFF pair */
+    PCA9685Span_t spans[PCA9685_MAX_SPANS]; /** Planned write spans */
+    uint8_t spanCount = 0U; /** Number of planned spans */
+    uint8_t channel = 0U; /** Channel index */
+    uint8_t reg = 0U; /** Register offset */
+    uint8_t span = 0U; /** Span index */
+    uint8_t written = 0U; /** Spans written to the device */
+    uint8_t active = 0U; /** Non-zero if a committed channel has a non-zero duty cycle */
+
+    memcpy(target, controllerConf->ledShadow, sizeof(target));
+    targetValid = controllerConf->shadowValid | frame->channelMask;
+
+    for (channel = 0U; channel < PCA9685_MAX_PWM_CHANNELS; channel++)
+    {
+        uint8_t *regs = &target[channel * 4U]; /** Channel target registers */
+
+        if ((frame->channelMask & (1U << channel)) != 0U)
+        {
+            if (frame->onValue[channel] > PCA9685_MAX_PWM_VALUE 
+                    || frame->offValue[channel] > PCA9685_MAX_PWM_VALUE)
+            {
+                return PCA9685LIB_ERROR;
+            }
+
+            regs[0] = (uint8_t) frame->onValue[channel];
+            regs[1] = (uint8_t) (frame->onValue[channel] >> 8U);
+            regs[2] = (uint8_t) frame->offValue[channel];
+            regs[3] = (uint8_t) (frame->offValue[channel] >> 8U);
+
+            if (PCA9685RegsToDuty(regs) != 0)
+            {
+                active = 1U;
+            }
+        }
+
+        if (channel > 0U && memcmp(regs, target, 4U) != 0)
+        {
+            uniform = 0U;
+        }
+    }
+
+    /* Registers of unknown channels are always dirty */
+    dirty = PCA9685ChannelsToRegs(frame->channelMask & (uint16_t) ~controllerConf->shadowValid);
+
+    for (reg = 0U; reg < PCA9685_LED_REGS_SIZE; reg++)
+    {
+        if (target[reg] != controllerConf->ledShadow[reg])
+        {
+            dirty |= (uint64_t) 1U << reg;
+        }
+    }
+
+    dirty &= PCA9685ChannelsToRegs(frame->channelMask);
+
+    if (dirty == 0U)
+    {
+        return PCA9685LIB_SUCCESS;
+    }
+
+    if (PCA9685AutoWake(controllerConf, active) != PCA9685LIB_SUCCESS)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    spanCount = PCA9685PlanSpans(&controllerConf->busCost, dirty, 
+                                    PCA9685ChannelsToRegs(targetValid), spans);
+
+    /* Whole board at the same value, a single ALL_LED write may be cheaper */
+    if (uniform != 0U && targetValid == 0xFFFFU 
+            && ((uint64_t) controllerConf->busCost.transactionNs + (5U * controllerConf->busCost.byteNs))
+                < PCA9685SpansCost(&controllerConf->busCost, spans, spanCount))
+    {
+        if (PCA9685WriteBurst(controllerConf, PCA9685_ALL_LED_ON_L_REG_ADDR, 
+                                4U, target) != PCA9685LIB_SUCCESS)
+        {
+            return PCA9685LIB_ERROR;
+        }
+
+        PCA9685SeqWriteBegin(&controllerConf->shadowSeq);
+        memcpy(controllerConf->ledShadow, target, sizeof(target));
+        controllerConf->shadowValid = 0xFFFFU;
+        PCA9685SeqWriteEnd(&controllerConf->shadowSeq);
+
+        return PCA9685LIB_SUCCESS;
+    }
+
+    /* Writing planned spans */
+    for (written = 0U; written < spanCount; written++)
+    {
+        if (PCA9685WriteBurst(controllerConf, PCA9685_LED0_ON_L_REG_ADDR + spans[written].offset, 
+                                spans[written].length, &target[spans[written].offset]) != PCA9685LIB_SUCCESS)
+        {
+            break;
+        }
+    }
+
+    /* Publishing the spans that reached the device at once, outside of bus transfers */
+    PCA9685SeqWriteBegin(&controllerConf->shadowSeq);
+
+    for (span = 0U; span < written; span++)
+    {
+        memcpy(&controllerConf->ledShadow[spans[span].offset], &target[spans[span].offset], 
+                spans[span].length);
+    }
+
+    if (written == spanCount)
+    {
+        controllerConf->shadowValid |= frame->channelMask;
+    }
+
+    PCA9685SeqWriteEnd(&controllerConf->shadowSeq);
+
+    return (written == spanCount) ? PCA9685LIB_SUCCESS : PCA9685LIB_ERROR;
+}
+
+/**
+ * \brief This function merges a frame into the slew-rate limiter targets.
+ * \param [in] controllerConf -- The configuration of the PCA9685 controller.
+ * \param [in] frame -- The frame to merge.
+ * \returns PCA9685LIB_SUCCESS if the frame is valid, otherwise PCA9685LIB_ERROR
+ *          and the targets are left untouched.
+ */
+int16_t PCA9685SlewMerge(PCA9685I2CConf_t *controllerConf, const PCA9685Frame_t *frame)
+{
+    uint8_t channel = 0U; /** Channel index */
+
+    for (channel = 0U; channel < PCA9685_MAX_PWM_CHANNELS; channel++)
+    {
+        if ((frame->channelMask & (1U << channel)) != 0U 
+                && (frame->onValue[channel] > PCA9685_MAX_PWM_VALUE 
+                    || frame->offValue[channel] > PCA9685_MAX_PWM_VALUE))
+        {
+            return PCA9685LIB_ERROR;
+        }
+    }
+
+    return PCA9685_FrameMerge(&controllerConf->slewTarget, frame);
+}
+
+/**
+ * \brief This function moves every pending channel towards its slew-rate limiter
+ *        target by at most its maximum delta, in duty cycle. The ON phase of the
+ *        target is kept. Targets are left pending, the caller clears the
+ *        reached ones once the frame is written.
+ * \param [in] controllerConf -- The configuration of the PCA9685 controller.
+ * \param [out] limited -- The frame to write for this tick.
+ * \returns The channels that reach their target with this frame.
+ */
+uint16_t PCA9685SlewLimit(PCA9685I2CConf_t *controllerConf, PCA9685Frame_t *limited)
+{
+    PCA9685Frame_t *target = &controllerConf->slewTarget; /** Slew-rate limiter targets */
+    int32_t current[PCA9685_MAX_PWM_CHANNELS]; /** Duty cycle in the shadow copy */
+    int32_t wanted[PCA9685_MAX_PWM_CHANNELS]; /** Target duty cycle */
+    int32_t limit[PCA9685_MAX_PWM_CHANNELS]; /** Maximum delta, unlimited for unknown channels */
+    int32_t next[PCA9685_MAX_PWM_CHANNELS]; /** Duty cycle to write */
+    uint8_t regs[4] = {0U}; /** Target registers of a channel */
+    uint16_t reached = 0U; /** Channels reaching their target */
+    uint8_t channel = 0U; /** Channel index */
+
+    for (channel = 0U; channel < PCA9685_MAX_PWM_CHANNELS; channel++)
+    {
+        regs[0] = (uint8_t) target->onValue[channel];
+        regs[1] = (uint8_t) (target->onValue[channel] >> 8U);
+        regs[2] = (uint8_t) target->offValue[channel];
+        regs[3] = (uint8_t) (target->offValue[channel] >> 8U);
+
+        current[channel] = PCA9685RegsToDuty(&controllerConf->ledShadow[channel * 4U]);
+        wanted[channel] = PCA9685RegsToDuty(regs);
+        limit[channel] = ((controllerConf->shadowValid & (1U << channel)) != 0U) 
+                            ? (int32_t) controllerConf->slewLimit[channel] : (int32_t) PCA9685_MAX_PWM_VALUE;
+    }
+
+    /* Branch-free over the whole board so that the compiler can vectorize it */
+    for (channel = 0U; channel < PCA9685_MAX_PWM_CHANNELS; channel++)
+    {
+        int32_t delta = wanted[channel] - current[channel]; /** Requested change */
+
+        delta = (delta > limit[channel]) ? limit[channel] : delta;
+        delta = (delta < -limit[channel]) ? -limit[channel] : delta;
+        next[channel] = current[channel] + delta;
+    }
+
+    limited->channelMask = target->channelMask;
+
+    for (channel = 0U; channel < PCA9685_MAX_PWM_CHANNELS; channel++)
+    {
+        uint16_t phase = (target->onValue[channel] < PCA9685_MAX_PWM_VALUE) ? target->onValue[channel] : 0U; /** Target ON phase */
+
+        if (next[channel] == wanted[channel])
+        {
+            /* Target reached, written exactly as requested */
+            limited->onValue[channel] = target->onValue[channel];
+            limited->offValue[channel] = target->offValue[channel];
+            reached |= (uint16_t) (1U << channel);
+        }
+        else if (next[channel] == 0)
+        {
+            limited->onValue[channel] = 0U;
+            limited->offValue[channel] = PCA9685_MAX_PWM_VALUE;
+        }
+        else if (next[channel] == PCA9685_MAX_PWM_VALUE)
+        {
+            limited->onValue[channel] = PCA9685_MAX_PWM_VALUE;
+            limited->offValue[channel] = 0U;
+        }
+        else
+        {
+            limited->onValue[channel] = phase;
+            limited->offValue[channel] = (uint16_t) ((phase + (uint32_t) next[channel]) 
+                                                        & (PCA9685_MAX_PWM_VALUE - 1U));
+        }
+    }
+
+    return (uint16_t) (reached & target->channelMask);
+}
+
+/**
+ * \brief This function writes a complete controller configuration in three
+ *        transactions. MODE1 is first written with SLEEP and AI set, as the
+ *        prescaler can only be changed while sleeping, then the prescaler, then
+ *        a single burst from MODE1 to LED15_OFF_H carries the final MODE1,
+ *        MODE2, the power-on subaddresses and all the LEDn registers.
+ *        The mode, prescaler and LED shadows are updated to match.
+ * \param [in] controllerConf -- The configuration of the PCA9685 controller.
+ * \param [in] mode1 -- MODE1 value, AI is forced and RESTART ignored.
+ * \param [in] mode2 -- MODE2 value.
+ * \param [in] prescaler -- Prescaler value, zero to leave PRE_SCALE untouched.
+ * \param [in] ledRegs -- Values of the PCA9685_LED_REGS_SIZE LEDn registers.
+ * \returns PCA9685LIB_SUCCESS if the configuration is successfully written,
+ *          otherwise PCA9685LIB_ERROR.
+ */
+int16_t PCA9685ApplyConfig(PCA9685I2CConf_t *controllerConf, uint8_t mode1, 
+                            uint8_t mode2, uint8_t prescaler, const uint8_t *ledRegs)
+{
+    uint8_t regs[PCA9685_CONFIG_REGS_SIZE] = {0U}; /** Burst payload, from MODE1 */
+    PCA9685Mode1Reg_u mode1Reg = {0U}; /** Final MODE1 value */
+    PCA9685Mode1Reg_u sleepReg = {0U}; /** MODE1 value while the prescaler is written */
+    int16_t status = PCA9685LIB_ERROR; /** Sequence status */
+
+    mode1Reg.regValue = mode1;
+    mode1Reg.bitfield.ai = 1;
+    mode1Reg.bitfield.restart = 0;
+
+    sleepReg.regValue = mode1Reg.regValue;
+    sleepReg.bitfield.sleep = 1;
+
+    regs[PCA9685_MODE1_REG_ADDR] = mode1Reg.regValue;
+    regs[PCA9685_MODE2_REG_ADDR] = mode2;
+    regs[PCA9685_I2C_SUBADDR1_REG_ADDR] = PCA9685_SUBADDR1_DEFAULT;
+    regs[PCA9685_I2C_SUBADDR2_REG_ADDR] = PCA9685_SUBADDR2_DEFAULT;
+    regs[PCA9685_I2C_SUBADDR3_REG_ADDR] = PCA9685_SUBADDR3_DEFAULT;
+    regs[PCA9685_ALLCALL_ADDR_REG_ADDR] = PCA9685_ALLCALL_ADDR_DEFAULT;
+    memcpy(&regs[PCA9685_LED0_ON_L_REG_ADDR], ledRegs, PCA9685_LED_REGS_SIZE);
+
+    PCA9685Lock(controllerConf);
+
+    if (PCA9685WriteReg(controllerConf, PCA9685_MODE1_REG_ADDR, sleepReg.regValue) == PCA9685LIB_SUCCESS)
+    {
+        PCA9685ModeShadowStore(controllerConf, PCA9685_MODE1_REG_ADDR, sleepReg.regValue);
+
+        if (prescaler == 0U)
+        {
+            status = PCA9685LIB_SUCCESS;
+        }
+        else if (PCA9685WriteReg(controllerConf, PCA9685_PRE_SCALE_REG_ADDR, prescaler) == PCA9685LIB_SUCCESS)
+        {
+            controllerConf->prescaler = prescaler;
+            controllerConf->modeShadowValid |= PCA9685_PRESCALER_SHADOW_VALID;
+            status = PCA9685LIB_SUCCESS;
+        }
+
+        if (status == PCA9685LIB_SUCCESS)
+        {
+            status = PCA9685WriteBurst(controllerConf, PCA9685_MODE1_REG_ADDR, 
+                                        PCA9685_CONFIG_REGS_SIZE, regs);
+        }
+    }
+
+    if (status == PCA9685LIB_SUCCESS)
+    {
+        PCA9685ModeShadowStore(controllerConf, PCA9685_MODE1_REG_ADDR, mode1Reg.regValue);
+        PCA9685ModeShadowStore(controllerConf, PCA9685_MODE2_REG_ADDR, mode2);
+
+        PCA9685SeqWriteBegin(&controllerConf->shadowSeq);
+
+        memcpy(controllerConf->ledShadow, ledRegs, PCA9685_LED_REGS_SIZE);
+        controllerConf->shadowValid = 0xFFFFU;
+
+        PCA9685SeqWriteEnd(&controllerConf->shadowSeq);
+    }
+
+    PCA9685Unlock(controllerConf);
+
+    return status;
+}
+
+/* Exported Functions Definitions */
+
+int16_t PCA9685_Init(PCA9685I2CConf_t *controllerConf, uint8_t i2cAddress, 
+                        uint16_t i2cDevNumber)
+{
+    
+    /* Verifying input */
+    
+    if (controllerConf == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    /* Opening I2C channel towards PCA9685 */
+    if (i2cInit(i2cDevNumber, &controllerConf->i2cConf) != US_I2C_SUCCESS)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    /* Setting PCA9685 I2C address */
+    controllerConf->i2cAddr = i2cAddress;
+    controllerConf->i2cDevNumber = i2cDevNumber;
+    controllerConf->busLock = NULL;
+
+    /* Device state is unknown until written or read back */
+    controllerConf->autoIncrement = 0U;
+    controllerConf->prescaler = PCA9685_DEFAULT_PRESCALER;
+    controllerConf->mode1Shadow = PCA9685_MODE1_DEFAULT;
+    controllerConf->mode2Shadow = PCA9685_MODE2_DEFAULT;
+    controllerConf->modeShadowValid = 0U;
+    controllerConf->shadowSeq = 0U;
+    controllerConf->shadowValid = 0U;
+    memset(controllerConf->ledShadow, 0, sizeof(controllerConf->ledShadow));
+
+    controllerConf->busCost.transactionNs = PCA9685_DEFAULT_TRANSACTION_NS;
+    controllerConf->busCost.byteNs = PCA9685_DEFAULT_BYTE_NS;
+    controllerConf->costEstimator = PCA9685BusEstimatorGet(i2cDevNumber);
+    controllerConf->costCalibration = (controllerConf->costEstimator != NULL) ? 1U : 0U;
+    memset(&controllerConf->health, 0, sizeof(controllerConf->health));
+    memset(&controllerConf->lastError, 0, sizeof(controllerConf->lastError));
+    controllerConf->autoSleepMs = 0U;
+    controllerConf->lastWriteNs = 0U;
+    controllerConf->autoSlept = 0U;
+
+    /* Transient errors are only retried once a policy is set */
+    controllerConf->retryPolicy.maxRetries = 0U;
+    controllerConf->retryPolicy.delayUs = 0U;
+    controllerConf->retryPolicy.retryMask = PCA9685_ERR_TRANSIENT_MASK;
+
+    /* No slew-rate limiting */
+    (void) PCA9685_SetSlewLimits(controllerConf, NULL);
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_InitWithProfile(PCA9685I2CConf_t *controllerConf, uint8_t i2cAddress, 
+                                    uint16_t i2cDevNumber, const PCA9685Profile_t *profile)
+{
+    uint8_t ledRegs[PCA9685_LED_REGS_SIZE] = {0U}; /** LEDn registers to write */
+    uint8_t prescale = 0U; /** Prescaler to write */
+
+    /* Verifying input */
+    if (controllerConf == NULL || profile == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (PCA9685_FrameToRegs(&profile->outputs, ledRegs) != PCA9685LIB_SUCCESS)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    /* A zero-initialized profile keeps the power-on frequency */
+    prescale = (profile->prescaler == 0U) ? PCA9685_DEFAULT_PRESCALER : profile->prescaler;
+
+    if (prescale < PCA9685_MIN_PRESCALER)
+    {
+        prescale = PCA9685_MIN_PRESCALER;
+    }
+
+    if (PCA9685_Init(controllerConf, i2cAddress, i2cDevNumber) != PCA9685LIB_SUCCESS)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    /* As for PCA9685_Init, nothing is left open on failure */
+    if (PCA9685ApplyConfig(controllerConf, profile->mode1, profile->mode2, 
+                            prescale, ledRegs) != PCA9685LIB_SUCCESS)
+    {
+        (void) PCA9685_Close(controllerConf);
+        return PCA9685LIB_ERROR;
+    }
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_GetMode1Reg(PCA9685I2CConf_t *controllerConf, PCA9685Mode1Reg_u *modeReg)
+{
+    
+    /* Verifying input */
+    if (controllerConf == NULL || modeReg == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    /* Reading mode 1 reg */
+    if (PCA9685ReadReg(controllerConf, PCA9685_MODE1_REG_ADDR, (uint8_t *) &modeReg->regValue) != PCA9685LIB_SUCCESS)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_SetMode1Reg(PCA9685I2CConf_t *controllerConf, PCA9685Mode1Reg_u modeReg)
+{
+
+    /* Verifying input */
+    if (controllerConf == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    PCA9685Lock(controllerConf);
+
+    /* Writing mode 1 reg */
+    if (PCA9685WriteReg(controllerConf, PCA9685_MODE1_REG_ADDR, modeReg.regValue) != PCA9685LIB_SUCCESS)
+    {
+        PCA9685Unlock(controllerConf);
+        return PCA9685LIB_ERROR;
+    }
+
+    PCA9685ModeShadowStore(controllerConf, PCA9685_MODE1_REG_ADDR, modeReg.regValue);
+
+    PCA9685Unlock(controllerConf);
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_GetMode2Reg(PCA9685I2CConf_t *controllerConf, PCA9685Mode2Reg_u *modeReg)
+{
+    
+    /* Verifying input */
+    if (controllerConf == NULL || modeReg == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    /* Reading mode 2 reg */
+    if (PCA9685ReadReg(controllerConf, PCA9685_MODE2_REG_ADDR, (uint8_t *) &modeReg->regValue) != PCA9685LIB_SUCCESS)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_SetMode2Reg(PCA9685I2CConf_t *controllerConf, PCA9685Mode2Reg_u modeReg)
+{
+
+    /* Verifying input */
+    if (controllerConf == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    PCA9685Lock(controllerConf);
+
+    /* Writing mode 2 reg */
+    if (PCA9685WriteReg(controllerConf, PCA9685_MODE2_REG_ADDR, (uint8_t) modeReg.regValue) != PCA9685LIB_SUCCESS)
+    {
+        PCA9685Unlock(controllerConf);
+        return PCA9685LIB_ERROR;
+    }
+
+    PCA9685ModeShadowStore(controllerConf, PCA9685_MODE2_REG_ADDR, modeReg.regValue);
+
+    PCA9685Unlock(controllerConf);
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_GetPrescaler(PCA9685I2CConf_t *controllerConf, uint8_t *prescale)
+{
+    
+    /* Verifying input */
+    if (controllerConf == NULL || prescale == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    PCA9685Lock(controllerConf);
+
+    /* Reading prescale reg */
+    if (PCA9685ReadReg(controllerConf, PCA9685_PRE_SCALE_REG_ADDR, prescale) != PCA9685LIB_SUCCESS)
+    {
+        PCA9685Unlock(controllerConf);
+        return PCA9685LIB_ERROR;
+    }
+
+    controllerConf->prescaler = *prescale;
+    controllerConf->modeShadowValid |= PCA9685_PRESCALER_SHADOW_VALID;
+
+    PCA9685Unlock(controllerConf);
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_SetPrescaler(PCA9685I2CConf_t *controllerConf, uint8_t prescale)
+{
+    PCA9685Mode1Reg_u mode1 = {0U}; /** MODE1 value */
+    uint8_t awake = 0U; /** Non-zero if the controller was running */
+    int16_t status = PCA9685LIB_SUCCESS; /** Write status */
+
+    /* Verifying input */
+    if (controllerConf == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (prescale < PCA9685_MIN_PRESCALER)
+    {
+        prescale = PCA9685_MIN_PRESCALER;
+    }
+
+    PCA9685Lock(controllerConf);
+
+    if (PCA9685ReadReg(controllerConf, PCA9685_MODE1_REG_ADDR, &mode1.regValue) != PCA9685LIB_SUCCESS)
+    {
+        PCA9685Unlock(controllerConf);
+        return PCA9685LIB_ERROR;
+    }
+
+    /* PRE_SCALE writes are ignored unless the oscillator is stopped */
+    awake = (uint8_t) (mode1.bitfield.sleep == 0U);
+
+    if (awake != 0U)
+    {
+        mode1.bitfield.restart = 0;
+        mode1.bitfield.sleep = 1;
+
+        if (PCA9685WriteReg(controllerConf, PCA9685_MODE1_REG_ADDR, mode1.regValue) != PCA9685LIB_SUCCESS)
+        {
+            PCA9685Unlock(controllerConf);
+            return PCA9685LIB_ERROR;
+        }
+
+        PCA9685ModeShadowStore(controllerConf, PCA9685_MODE1_REG_ADDR, mode1.regValue);
+    }
+
+    /* Writing prescale reg */
+    status = PCA9685WriteReg(controllerConf, PCA9685_PRE_SCALE_REG_ADDR, prescale);
+
+    if (status == PCA9685LIB_SUCCESS)
+    {
+        controllerConf->prescaler = prescale;
+        controllerConf->modeShadowValid |= PCA9685_PRESCALER_SHADOW_VALID;
+    }
+
+    /* Running controllers are resumed even if the prescaler could not be written */
+    if (awake != 0U && PCA9685_FastResume(controllerConf) != PCA9685LIB_SUCCESS)
+    {
+        status = PCA9685LIB_ERROR;
+    }
+
+    PCA9685Unlock(controllerConf);
+
+    return status;
+}
+
+int16_t PCA9685_GetPWM(PCA9685I2CConf_t *controllerConf, uint8_t channel, 
+                        uint16_t *onValue, uint16_t *offValue)
+{
+    uint8_t regValues[4] = {0U}; /** LEDn ON_L, ON_H, OFF_L, OFF_H values */
+
+    /* Verifying input */
+    if (controllerConf == NULL || onValue == NULL || offValue == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (channel >= PCA9685_MAX_PWM_CHANNELS)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    PCA9685Lock(controllerConf);
+
+    /* Reading on and off values */
+    if (PCA9685ReadBurst(controllerConf, PCA9685_LED0_ON_L_REG_ADDR + (channel * 4U), 
+                            4U, regValues) != PCA9685LIB_SUCCESS)
+    {
+        PCA9685Unlock(controllerConf);
+        return PCA9685LIB_ERROR;
+    }
+
+    *onValue = (uint16_t) ((regValues[1] << 8U) | regValues[0]);
+    *offValue = (uint16_t) ((regValues[3] << 8U) | regValues[2]);
+
+    /* Refreshing shadow copy with device content */
+    PCA9685SeqWriteBegin(&controllerConf->shadowSeq);
+    PCA9685ShadowStore(controllerConf, channel, *onValue, *offValue);
+    PCA9685SeqWriteEnd(&controllerConf->shadowSeq);
+
+    PCA9685Unlock(controllerConf);
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_SetPWM(PCA9685I2CConf_t *controllerConf, uint8_t channel, 
+                        uint16_t onValue, uint16_t offValue)
+{
+    uint8_t regValues[4] = {0U}; /** LEDn ON_L, ON_H, OFF_L, OFF_H values */
+    uint8_t *shadow = NULL; /** Channel shadow registers */
+    int16_t status = PCA9685LIB_SUCCESS; /** Write status */
+
+    /* Verifying input */
+    if (controllerConf == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (channel >= PCA9685_MAX_PWM_CHANNELS)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (onValue > PCA9685_MAX_PWM_VALUE || offValue > PCA9685_MAX_PWM_VALUE)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    regValues[0] = (uint8_t) onValue;
+    regValues[1] = (uint8_t) (onValue >> 8U);
+    regValues[2] = (uint8_t) offValue;
+    regValues[3] = (uint8_t) (offValue >> 8U);
+
+    shadow = &controllerConf->ledShadow[channel * 4U];
+
+    PCA9685Lock(controllerConf);
+
+    if (PCA9685AutoWake(controllerConf, (uint8_t) (PCA9685RegsToDuty(regValues) != 0)) != PCA9685LIB_SUCCESS)
+    {
+        PCA9685Unlock(controllerConf);
+        return PCA9685LIB_ERROR;
+    }
+
+    if ((controllerConf->shadowValid & (1U << channel)) != 0U
+            && shadow[0] == regValues[0] && shadow[1] == regValues[1])
+    {
+        /* ON phase unchanged, writing off value only */
+        status = PCA9685WriteBurst(controllerConf, PCA9685_LED0_OFF_L_REG_ADDR + (channel * 4U), 
+                                    2U, &regValues[2]);
+    }
+    else
+    {
+        /* Writing on and off values */
+        status = PCA9685WriteBurst(controllerConf, PCA9685_LED0_ON_L_REG_ADDR + (channel * 4U), 
+                                    4U, regValues);
+    }
+
+    if (status == PCA9685LIB_SUCCESS)
+    {
+        PCA9685SeqWriteBegin(&controllerConf->shadowSeq);
+        PCA9685ShadowStore(controllerConf, channel, onValue, offValue);
+        PCA9685SeqWriteEnd(&controllerConf->shadowSeq);
+
+        /* Direct writes bypass the slew-rate limiter and cancel its pending target */
+        controllerConf->slewTarget.channelMask &= (uint16_t) ~(1U << channel);
+    }
+
+    PCA9685Unlock(controllerConf);
+
+    return status;
+}
+
+int16_t PCA9685_SetPWMOff(PCA9685I2CConf_t *controllerConf, uint8_t channel, 
+                            uint16_t offValue)
+{
+    uint8_t regValues[2] = {0U}; /** LEDn OFF_L, OFF_H values */
+
+    /* Verifying input */
+    if (controllerConf == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (channel >= PCA9685_MAX_PWM_CHANNELS)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (offValue > PCA9685_MAX_PWM_VALUE)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    regValues[0] = (uint8_t) offValue;
+    regValues[1] = (uint8_t) (offValue >> 8U);
+
+    PCA9685Lock(controllerConf);
+
+    /* ON value may be unknown, any OFF value but full OFF may turn the channel on */
+    if (PCA9685AutoWake(controllerConf, (uint8_t) ((offValue & PCA9685_MAX_PWM_VALUE) == 0U)) 
+            != PCA9685LIB_SUCCESS)
+    {
+        PCA9685Unlock(controllerConf);
+        return PCA9685LIB_ERROR;
+    }
+
+    /* Writing off value */
+    if (PCA9685WriteBurst(controllerConf, PCA9685_LED0_OFF_L_REG_ADDR + (channel * 4U), 
+                            2U, regValues) != PCA9685LIB_SUCCESS)
+    {
+        PCA9685Unlock(controllerConf);
+        return PCA9685LIB_ERROR;
+    }
+
+    /* ON registers are untouched, shadow is only updated where known */
+    PCA9685SeqWriteBegin(&controllerConf->shadowSeq);
+    controllerConf->ledShadow[(channel * 4U) + 2U] = regValues[0];
+    controllerConf->ledShadow[(channel * 4U) + 3U] = regValues[1];
+    PCA9685SeqWriteEnd(&controllerConf->shadowSeq);
+
+    /* Direct writes bypass the slew-rate limiter and cancel its pending target */
+    controllerConf->slewTarget.channelMask &= (uint16_t) ~(1U << channel);
+
+    PCA9685Unlock(controllerConf);
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_GetCachedPWM(const PCA9685I2CConf_t *controllerConf, uint8_t channel, 
+                                uint16_t *onValue, uint16_t *offValue)
+{
+    PCA9685Frame_t frame; /** Shadow snapshot */
+
+    /* Verifying input */
+    if (controllerConf == NULL || channel >= PCA9685_MAX_PWM_CHANNELS 
+            || onValue == NULL || offValue == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (PCA9685_GetPWMSnapshot(controllerConf, &frame) != PCA9685LIB_SUCCESS 
+            || (frame.channelMask & (1U << channel)) == 0U)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    *onValue = frame.onValue[channel];
+    *offValue = frame.offValue[channel];
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_GetPWMSnapshot(const PCA9685I2CConf_t *controllerConf, PCA9685Frame_t *frame)
+{
+    uint8_t shadow[PCA9685_LED_REGS_SIZE]; /** Copy of the shadow registers */
+    uint16_t valid = 0U; /** Copy of the shadow valid mask */
+    uint32_t start = 0U; /** Sequence value at the start of the copy */
+    uint32_t attempt = 0U; /** Copy attempts */
+    uint8_t channel = 0U; /** Channel index */
+
+    /* Verifying input */
+    if (controllerConf == NULL || frame == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    for (attempt = 0U; attempt < PCA9685_SEQLOCK_SPINS; attempt++)
+    {
+        if (PCA9685SeqReadBegin(&controllerConf->shadowSeq, &start) == 0U)
+        {
+            return PCA9685LIB_ERROR;
+        }
+
+        memcpy(shadow, controllerConf->ledShadow, sizeof(shadow));
+        valid = controllerConf->shadowValid;
+
+        if (PCA9685SeqReadRetry(&controllerConf->shadowSeq, start) == 0U)
+        {
+            break;
+        }
+    }
+
+    if (attempt == PCA9685_SEQLOCK_SPINS)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    for (channel = 0U; channel < PCA9685_MAX_PWM_CHANNELS; channel++)
+    {
+        frame->onValue[channel] = (uint16_t) (shadow[channel * 4U] 
+                                    | (shadow[(channel * 4U) + 1U] << 8U));
+        frame->offValue[channel] = (uint16_t) (shadow[(channel * 4U) + 2U] 
+                                    | (shadow[(channel * 4U) + 3U] << 8U));
+
+        /* Full ON/OFF bits are reported as PCA9685_MAX_PWM_VALUE, whatever the count bits */
+        if (frame->onValue[channel] >= PCA9685_MAX_PWM_VALUE)
+        {
+            frame->onValue[channel] = PCA9685_MAX_PWM_VALUE;
+        }
+
+        if (frame->offValue[channel] >= PCA9685_MAX_PWM_VALUE)
+        {
+            frame->offValue[channel] = PCA9685_MAX_PWM_VALUE;
+        }
+    }
+
+    frame->channelMask = valid;
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_ScrubChannels(PCA9685I2CConf_t *controllerConf, uint16_t channelMask, 
+                                uint16_t *mismatched)
+{
+    uint8_t readBack[PCA9685_LED_REGS_SIZE] = {0U}; /** Registers read back */
+    PCA9685Span_t spans[PCA9685_MAX_SPANS]; /** Planned repair spans */
+    uint64_t dirty = 0U; /** Registers that differ from the shadow copy */
+    uint8_t spanCount = 0U; /** Number of planned spans */
+    uint8_t first = 0U; /** First register read */
+    uint8_t last = 0U; /** Last register read */
+    uint8_t reg = 0U; /** Register offset */
+    uint8_t channel = 0U; /** Channel index */
+    uint8_t span = 0U; /** Span index */
+    int16_t status = PCA9685LIB_SUCCESS; /** Scrub status */
+
+    /* Verifying input */
+    if (controllerConf == NULL || mismatched == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    *mismatched = 0U;
+
+    PCA9685Lock(controllerConf);
+
+    channelMask &= controllerConf->shadowValid;
+
+    if (channelMask == 0U)
+    {
+        PCA9685Unlock(controllerConf);
+        return PCA9685LIB_SUCCESS;
+    }
+
+    first = (uint8_t) (__builtin_ctz(channelMask) * 4U);
+    last = (uint8_t) (((31U - __builtin_clz(channelMask)) * 4U) + 3U);
+
+    if (PCA9685ReadBurst(controllerConf, PCA9685_LED0_ON_L_REG_ADDR + first, 
+                            (uint8_t) (last - first + 1U), &readBack[first]) != PCA9685LIB_SUCCESS)
+    {
+        PCA9685Unlock(controllerConf);
+        return PCA9685LIB_ERROR;
+    }
+
+    for (reg = first; reg <= last; reg++)
+    {
+        if (readBack[reg] != controllerConf->ledShadow[reg])
+        {
+            dirty |= (uint64_t) 1U << reg;
+        }
+    }
+
+    dirty &= PCA9685ChannelsToRegs(channelMask);
+
+    for (channel = 0U; channel < PCA9685_MAX_PWM_CHANNELS; channel++)
+    {
+        if ((dirty & PCA9685ChannelsToRegs((uint16_t) (1U << channel))) != 0U)
+        {
+            *mismatched |= (uint16_t) (1U << channel);
+        }
+    }
+
+    if (dirty != 0U)
+    {
+        /* The shadow copy holds what was committed, the device is brought back to it */
+        spanCount = PCA9685PlanSpans(&controllerConf->busCost, dirty, 
+                                        PCA9685ChannelsToRegs(controllerConf->shadowValid), spans);
+
+        for (span = 0U; span < spanCount && status == PCA9685LIB_SUCCESS; span++)
+        {
+            status = PCA9685WriteBurst(controllerConf, PCA9685_LED0_ON_L_REG_ADDR + spans[span].offset, 
+                                        spans[span].length, &controllerConf->ledShadow[spans[span].offset]);
+        }
+    }
+
+    PCA9685Unlock(controllerConf);
+
+    return status;
+}
+
+int16_t PCA9685_GetAllPWM(PCA9685I2CConf_t *controllerConf, uint16_t *onValue, 
+                            uint16_t *offValue)
+{
+    uint8_t regValues[4] = {0U}; /** ALL_LED ON_L, ON_H, OFF_L, OFF_H values */
+
+    /* Verifying input */
+    if (controllerConf == NULL || onValue == NULL || offValue == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    /* Reading on and off values */
+    if (PCA9685ReadBurst(controllerConf, PCA9685_ALL_LED_ON_L_REG_ADDR, 
+                            4U, regValues) != PCA9685LIB_SUCCESS)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    *onValue = (uint16_t) ((regValues[1] << 8U) | regValues[0]);
+    *offValue = (uint16_t) ((regValues[3] << 8U) | regValues[2]);
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_SetAllPWM(PCA9685I2CConf_t *controllerConf, uint16_t onValue, 
+                            uint16_t offValue)
+{
+    uint8_t regValues[4] = {0U}; /** ALL_LED ON_L, ON_H, OFF_L, OFF_H values */
+    uint8_t channel = 0U; /** Channel index */
+
+    /* Verifying input */
+    if (controllerConf == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (onValue > PCA9685_MAX_PWM_VALUE || offValue > PCA9685_MAX_PWM_VALUE)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    regValues[0] = (uint8_t) onValue;
+    regValues[1] = (uint8_t) (onValue >> 8U);
+    regValues[2] = (uint8_t) offValue;
+    regValues[3] = (uint8_t) (offValue >> 8U);
+
+    PCA9685Lock(controllerConf);
+
+    if (PCA9685AutoWake(controllerConf, (uint8_t) (PCA9685RegsToDuty(regValues) != 0)) != PCA9685LIB_SUCCESS)
+    {
+        PCA9685Unlock(controllerConf);
+        return PCA9685LIB_ERROR;
+    }
+
+    /* Writing on and off values */
+    if (PCA9685WriteBurst(controllerConf, PCA9685_ALL_LED_ON_L_REG_ADDR, 
+                            4U, regValues) != PCA9685LIB_SUCCESS)
+    {
+        PCA9685Unlock(controllerConf);
+        return PCA9685LIB_ERROR;
+    }
+
+    PCA9685SeqWriteBegin(&controllerConf->shadowSeq);
+
+    for (channel = 0U; channel < PCA9685_MAX_PWM_CHANNELS; channel++)
+    {
+        PCA9685ShadowStore(controllerConf, channel, onValue, offValue);
+    }
+
+    PCA9685SeqWriteEnd(&controllerConf->shadowSeq);
+
+    /* Direct writes bypass the slew-rate limiter and cancel its pending targets */
+    controllerConf->slewTarget.channelMask = 0U;
+
+    PCA9685Unlock(controllerConf);
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_CommitFrame(PCA9685I2CConf_t *controllerConf, const PCA9685Frame_t *frame)
+{
+    PCA9685Frame_t limited; /** Frame after slew-rate limiting */
+    uint16_t reached = 0U; /** Channels reaching their target */
+    int16_t status = PCA9685LIB_ERROR; /** Commit status */
+
+    /* Verifying input */
+    if (controllerConf == NULL || frame == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    PCA9685Lock(controllerConf);
+
+    if (controllerConf->slewEnabled == 0U)
+    {
+        status = PCA9685WriteFrame(controllerConf, frame);
+    }
+    else if (PCA9685SlewMerge(controllerConf, frame) == PCA9685LIB_SUCCESS)
+    {
+        reached = PCA9685SlewLimit(controllerConf, &limited);
+        status = PCA9685WriteFrame(controllerConf, &limited);
+
+        /* Reached channels stay pending until their final step is written */
+        if (status == PCA9685LIB_SUCCESS)
+        {
+            controllerConf->slewTarget.channelMask &= (uint16_t) ~reached;
+        }
+    }
+
+    PCA9685Unlock(controllerConf);
+
+    return status;
+}
+
+int16_t PCA9685_SetSlewLimits(PCA9685I2CConf_t *controllerConf, const uint16_t *maxDelta)
+{
+    uint8_t channel = 0U; /** Channel index */
+
+    /* Verifying input */
+    if (controllerConf == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    PCA9685Lock(controllerConf);
+
+    controllerConf->slewEnabled = 0U;
+    controllerConf->slewTarget.channelMask = 0U;
+
+    for (channel = 0U; channel < PCA9685_MAX_PWM_CHANNELS; channel++)
+    {
+        /* A zero limit leaves the channel unlimited */
+        controllerConf->slewLimit[channel] = (maxDelta == NULL || maxDelta[channel] == 0U) 
+                                                ? PCA9685_MAX_PWM_VALUE : maxDelta[channel];
+
+        if (controllerConf->slewLimit[channel] < PCA9685_MAX_PWM_VALUE)
+        {
+            controllerConf->slewEnabled = 1U;
+        }
+    }
+
+    PCA9685Unlock(controllerConf);
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_SlewStep(PCA9685I2CConf_t *controllerConf)
+{
+    PCA9685Frame_t limited; /** Frame after slew-rate limiting */
+    uint16_t reached = 0U; /** Channels reaching their target */
+    int16_t status = PCA9685LIB_SUCCESS; /** Step status */
+
+    /* Verifying input */
+    if (controllerConf == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    PCA9685Lock(controllerConf);
+
+    if (controllerConf->slewEnabled != 0U && controllerConf->slewTarget.channelMask != 0U)
+    {
+        reached = PCA9685SlewLimit(controllerConf, &limited);
+        status = PCA9685WriteFrame(controllerConf, &limited);
+
+        /* Reached channels stay pending until their final step is written */
+        if (status == PCA9685LIB_SUCCESS)
+        {
+            controllerConf->slewTarget.channelMask &= (uint16_t) ~reached;
+        }
+    }
+
+    PCA9685Unlock(controllerConf);
+
+    return status;
+}
+
+int16_t PCA9685_FrameSetDuty(PCA9685Frame_t *frame, uint8_t channel, uint16_t duty)
+{
+
+    /* Verifying input */
+    if (frame == NULL || channel >= PCA9685_MAX_PWM_CHANNELS || duty > PCA9685_MAX_PWM_VALUE)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (duty == 0U)
+    {
+        /* Full OFF */
+        frame->onValue[channel] = 0U;
+        frame->offValue[channel] = PCA9685_MAX_PWM_VALUE;
+    }
+    else if (duty == PCA9685_MAX_PWM_VALUE)
+    {
+        /* Full ON */
+        frame->onValue[channel] = PCA9685_MAX_PWM_VALUE;
+        frame->offValue[channel] = 0U;
+    }
+    else
+    {
+        frame->onValue[channel] = 0U;
+        frame->offValue[channel] = duty;
+    }
+
+    frame->channelMask |= (uint16_t) (1U << channel);
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_FrameMerge(PCA9685Frame_t *into, const PCA9685Frame_t *frame)
+{
+    uint8_t channel = 0U; /** Channel index */
+
+    /* Verifying input */
+    if (into == NULL || frame == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    for (channel = 0U; channel < PCA9685_MAX_PWM_CHANNELS; channel++)
+    {
+        if ((frame->channelMask & (1U << channel)) != 0U)
+        {
+            into->onValue[channel] = frame->onValue[channel];
+            into->offValue[channel] = frame->offValue[channel];
+        }
+    }
+
+    into->channelMask |= frame->channelMask;
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_FrameToRegs(const PCA9685Frame_t *frame, uint8_t *ledRegs)
+{
+    uint8_t channel = 0U; /** Channel index */
+
+    /* Verifying input */
+    if (frame == NULL || ledRegs == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    for (channel = 0U; channel < PCA9685_MAX_PWM_CHANNELS; channel++)
+    {
+        uint8_t *regs = &ledRegs[channel * 4U]; /** Channel registers */
+
+        if ((frame->channelMask & (1U << channel)) == 0U)
+        {
+            memset(regs, 0, 4U);
+            regs[3] = (uint8_t) (PCA9685_MAX_PWM_VALUE >> 8U);
+            continue;
+        }
+
+        if (frame->onValue[channel] > PCA9685_MAX_PWM_VALUE 
+                || frame->offValue[channel] > PCA9685_MAX_PWM_VALUE)
+        {
+            return PCA9685LIB_ERROR;
+        }
+
+        regs[0] = (uint8_t) frame->onValue[channel];
+        regs[1] = (uint8_t) (frame->onValue[channel] >> 8U);
+        regs[2] = (uint8_t) frame->offValue[channel];
+        regs[3] = (uint8_t) (frame->offValue[channel] >> 8U);
+    }
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_SetBusCost(PCA9685I2CConf_t *controllerConf, uint32_t transactionNs, 
+                            uint32_t byteNs)
+{
+
+    /* Verifying input */
+    if (controllerConf == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    PCA9685Lock(controllerConf);
+    controllerConf->busCost.transactionNs = transactionNs;
+    controllerConf->busCost.byteNs = byteNs;
+    PCA9685Unlock(controllerConf);
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_SetCostCalibration(PCA9685I2CConf_t *controllerConf, uint8_t enable)
+{
+
+    /* Verifying input */
+    if (controllerConf == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    /* Handles past the size of the estimator registry cannot be calibrated */
+    if (enable != 0U && controllerConf->costEstimator == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    /* The estimator is shared by the bus, its samples are kept */
+    PCA9685Lock(controllerConf);
+    controllerConf->costCalibration = (enable != 0U) ? 1U : 0U;
+    PCA9685Unlock(controllerConf);
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_SafetyStop(PCA9685I2CConf_t *controllerConf, uint8_t actions)
+{
+    uint8_t fullOff = (uint8_t) (PCA9685_MAX_PWM_VALUE >> 8U); /** OFF_H full OFF bit */
+    uint8_t channel = 0U; /** Channel index */
+    int16_t status = PCA9685LIB_SUCCESS; /** Actions status */
+
+    /* Verifying input */
+    if (controllerConf == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    PCA9685Lock(controllerConf);
+
+    /* Slewing channels would be driven back towards their targets */
+    controllerConf->slewTarget.channelMask = 0U;
+
+    if ((actions & PCA9685_SAFETY_ALL_OFF) != 0U)
+    {
+        if (PCA9685WriteReg(controllerConf, PCA9685_ALL_LED_OFF_H_REG_ADDR, fullOff) != PCA9685LIB_SUCCESS)
+        {
+            status = PCA9685LIB_ERROR;
+        }
+        else
+        {
+            /* Only OFF_H changed, channels not known before are still not known */
+            PCA9685SeqWriteBegin(&controllerConf->shadowSeq);
+
+            for (channel = 0U; channel < PCA9685_MAX_PWM_CHANNELS; channel++)
+            {
+                controllerConf->ledShadow[(channel * 4U) + 3U] = fullOff;
+            }
+
+            PCA9685SeqWriteEnd(&controllerConf->shadowSeq);
+        }
+    }
+
+    if ((actions & PCA9685_SAFETY_DISABLE_OUTPUT) != 0U 
+            && PCA9685_DisableOutput(controllerConf) != PCA9685LIB_SUCCESS)
+    {
+        status = PCA9685LIB_ERROR;
+    }
+
+    if ((actions & PCA9685_SAFETY_SLEEP) != 0U 
+            && PCA9685_Sleep(controllerConf) != PCA9685LIB_SUCCESS)
+    {
+        status = PCA9685LIB_ERROR;
+    }
+
+    PCA9685Unlock(controllerConf);
+
+    return status;
+}
+
+int16_t PCA9685_WriteFailSafe(PCA9685I2CConf_t *controllerConf, const uint8_t *ledRegs, 
+                                uint8_t actions)
+{
+    int16_t status = PCA9685LIB_SUCCESS; /** Actions status */
+    uint8_t active = 0U; /** Non-zero if the frame has a non-zero duty cycle */
+    uint8_t channel = 0U; /** Channel index */
+
+    /* Verifying input */
+    if (controllerConf == NULL || ledRegs == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    for (channel = 0U; channel < PCA9685_MAX_PWM_CHANNELS; channel++)
+    {
+        if (PCA9685RegsToDuty(&ledRegs[channel * 4U]) != 0)
+        {
+            active = 1U;
+        }
+    }
+
+    PCA9685Lock(controllerConf);
+
+    /* Slewing channels would be driven back towards their targets */
+    controllerConf->slewTarget.channelMask = 0U;
+
+    /* An auto-slept controller would hold the fail-safe frame without running it */
+    if (PCA9685AutoWake(controllerConf, active) != PCA9685LIB_SUCCESS)
+    {
+        status = PCA9685LIB_ERROR;
+    }
+    else if (PCA9685WriteBurst(controllerConf, PCA9685_LED0_ON_L_REG_ADDR, 
+                            PCA9685_LED_REGS_SIZE, (uint8_t *) ledRegs) != PCA9685LIB_SUCCESS)
     {
-        return PCA9685LIB_ERROR;
+        status = PCA9685LIB_ERROR;
+    }
+    else
+    {
+        PCA9685SeqWriteBegin(&controllerConf->shadowSeq);
+        memcpy(controllerConf->ledShadow, ledRegs, PCA9685_LED_REGS_SIZE);
+        controllerConf->shadowValid = 0xFFFFU;
+        PCA9685SeqWriteEnd(&controllerConf->shadowSeq);
     }
 
-    /* Reading mode 2 reg */
-    if (PCA9685ReadReg(controllerConf, PCA9685_MODE2_REG_ADDR, (uint8_t *) &modeReg->regValue) != PCA9685LIB_SUCCESS)
+    /* Outputs are disabled or stopped even if the frame could not be written */
+    actions &= (uint8_t) ~PCA9685_SAFETY_ALL_OFF;
+
+    if (actions != 0U && PCA9685_SafetyStop(controllerConf, actions) != PCA9685LIB_SUCCESS)
     {
-        return PCA9685LIB_ERROR;
+        status = PCA9685LIB_ERROR;
     }
 
-    return PCA9685LIB_SUCCESS;
+    PCA9685Unlock(controllerConf);
+
+    return status;
 }
 
-int16_t PCA9685_SetMode2Reg(PCA9685I2CConf_t *controllerConf, PCA9685Mode2Reg_u modeReg)
+int16_t PCA9685_CheckState(PCA9685I2CConf_t *controllerConf, uint8_t *stateLost)
 {
+    PCA9685Mode1Reg_u mode1 = {0U}; /** MODE1 value read back */
 
     /* Verifying input */
-    if (controllerConf == NULL)
+    if (controllerConf == NULL || stateLost == NULL)
     {
         return PCA9685LIB_ERROR;
     }
 
-    /* Writing mode 2 reg */
-    if (PCA9685WriteReg(controllerConf, PCA9685_MODE2_REG_ADDR, (uint8_t) modeReg.regValue) != PCA9685LIB_SUCCESS)
+    PCA9685Lock(controllerConf);
+
+    if (PCA9685ReadReg(controllerConf, PCA9685_MODE1_REG_ADDR, &mode1.regValue) != PCA9685LIB_SUCCESS)
     {
+        PCA9685Unlock(controllerConf);
         return PCA9685LIB_ERROR;
     }
 
-    return PCA9685LIB_SUCCESS;
-}
+    /* RESTART reads back set whenever PWM was running before sleep */
+    mode1.bitfield.restart = 0;
 
-int16_t PCA9685_GetPrescaler(PCA9685I2CConf_t *controllerConf, uint8_t *prescale)
-{
-    
-    /* Verifying input */
-    if (controllerConf == NULL || prescale == NULL)
+    if ((controllerConf->modeShadowValid & PCA9685_MODE1_SHADOW_VALID) != 0U)
     {
-        return PCA9685LIB_ERROR;
+        *stateLost = (uint8_t) (mode1.regValue != controllerConf->mode1Shadow);
+    }
+    else
+    {
+        *stateLost = (uint8_t) (mode1.regValue == PCA9685_MODE1_DEFAULT 
+                                    && controllerConf->autoIncrement != 0U);
     }
 
-    /* Reading prescale reg */
-    if (PCA9685ReadReg(controllerConf, PCA9685_PRE_SCALE_REG_ADDR, prescale) != PCA9685LIB_SUCCESS)
+    if (*stateLost != 0U)
     {
-        return PCA9685LIB_ERROR;
+        /* Bursts must set AI again before being sent */
+        controllerConf->autoIncrement = mode1.bitfield.ai;
+    }
+    else if ((controllerConf->modeShadowValid & PCA9685_PRESCALER_SHADOW_VALID) == 0U 
+                && PCA9685ReadReg(controllerConf, PCA9685_PRE_SCALE_REG_ADDR, 
+                                    &controllerConf->prescaler) == PCA9685LIB_SUCCESS)
+    {
+        /* Learning the prescaler while the state is good, for a later restore */
+        controllerConf->modeShadowValid |= PCA9685_PRESCALER_SHADOW_VALID;
     }
 
+    PCA9685Unlock(controllerConf);
+
     return PCA9685LIB_SUCCESS;
 }
 
-int16_t PCA9685_SetPrescaler(PCA9685I2CConf_t *controllerConf, uint8_t prescale)
+int16_t PCA9685_RestoreState(PCA9685I2CConf_t *controllerConf)
 {
+    uint8_t ledRegs[PCA9685_LED_REGS_SIZE] = {0U}; /** LEDn registers to restore */
+    uint8_t mode1 = PCA9685_MODE1_DEFAULT; /** MODE1 to restore */
+    uint8_t mode2 = PCA9685_MODE2_DEFAULT; /** MODE2 to restore */
+    uint8_t prescaler = 0U; /** Prescaler to restore, zero to skip */
+    uint8_t channel = 0U; /** Channel index */
+    int16_t status = PCA9685LIB_ERROR; /** Restore status */
 
     /* Verifying input */
     if (controllerConf == NULL)
@@ -233,352 +2236,395 @@ int16_t PCA9685_SetPrescaler(PCA9685I2CConf_t *controllerConf, uint8_t prescale)
         return PCA9685LIB_ERROR;
     }
 
-    if (prescale < PCA9685_MIN_PRESCALER)
+    PCA9685Lock(controllerConf);
+
+    if ((controllerConf->modeShadowValid & PCA9685_MODE1_SHADOW_VALID) != 0U)
     {
-        prescale = PCA9685_MIN_PRESCALER;
+        mode1 = controllerConf->mode1Shadow;
     }
 
-    /* Writing prescale reg */
-    if (PCA9685WriteReg(controllerConf, PCA9685_PRE_SCALE_REG_ADDR, prescale) != PCA9685LIB_SUCCESS)
+    if ((controllerConf->modeShadowValid & PCA9685_MODE2_SHADOW_VALID) != 0U)
     {
-        return PCA9685LIB_ERROR;
+        mode2 = controllerConf->mode2Shadow;
     }
 
-    return PCA9685LIB_SUCCESS;
+    /* A guessed prescaler would silently change the PWM frequency */
+    if ((controllerConf->modeShadowValid & PCA9685_PRESCALER_SHADOW_VALID) != 0U)
+    {
+        prescaler = controllerConf->prescaler;
+    }
+
+    /* Channels never written keep their power-on full OFF value */
+    for (channel = 0U; channel < PCA9685_MAX_PWM_CHANNELS; channel++)
+    {
+        if ((controllerConf->shadowValid & (1U << channel)) != 0U)
+        {
+            memcpy(&ledRegs[channel * 4U], &controllerConf->ledShadow[channel * 4U], 4U);
+        }
+        else
+        {
+            ledRegs[(channel * 4U) + 3U] = (uint8_t) (PCA9685_MAX_PWM_VALUE >> 8U);
+        }
+    }
+
+    status = PCA9685ApplyConfig(controllerConf, mode1, mode2, prescaler, ledRegs);
+
+    PCA9685Unlock(controllerConf);
+
+    return status;
 }
 
-int16_t PCA9685_GetPWM(PCA9685I2CConf_t *controllerConf, uint8_t channel, 
-                        uint16_t *onValue, uint16_t *offValue)
+int16_t PCA9685_FastResume(PCA9685I2CConf_t *controllerConf)
 {
-
-    uint8_t tmpValue_l = 0U; /** Temporary value to store lowbyte */
-    uint8_t tmpValue_h = 0U; /** Temporary value to store highbyte */
+    PCA9685Mode1Reg_u mode1 = {0U}; /** MODE1 value */
+    uint64_t wakeNs = 0U; /** Time SLEEP was cleared */
 
     /* Verifying input */
-    if (controllerConf == NULL || onValue == NULL || offValue == NULL)
+    if (controllerConf == NULL)
     {
         return PCA9685LIB_ERROR;
     }
 
-    if (channel > PCA9685_MAX_PWM_CHANNELS)
-    {
-        return PCA9685LIB_ERROR;
-    }
+    PCA9685Lock(controllerConf);
 
-    /* Reading on value */
-    if (PCA9685ReadReg(controllerConf, PCA9685_LED0_ON_L_REG_ADDR + (channel * 4U), 
-                        (uint8_t *) &tmpValue_l) != PCA9685LIB_SUCCESS)
+    if (PCA9685ReadReg(controllerConf, PCA9685_MODE1_REG_ADDR, &mode1.regValue) != PCA9685LIB_SUCCESS)
     {
+        PCA9685Unlock(controllerConf);
         return PCA9685LIB_ERROR;
     }
 
-    if (PCA9685ReadReg(controllerConf, PCA9685_LED0_ON_H_REG_ADDR + (channel * 4U), 
-                        (uint8_t *) &tmpValue_h) != PCA9685LIB_SUCCESS)
+    if (mode1.bitfield.restart == 0U && mode1.bitfield.sleep == 0U)
     {
-        return PCA9685LIB_ERROR;
+        /* Already running, nothing to resume */
+        PCA9685ModeShadowStore(controllerConf, PCA9685_MODE1_REG_ADDR, mode1.regValue);
+        PCA9685Unlock(controllerConf);
+        return PCA9685LIB_SUCCESS;
     }
 
-    *onValue = (uint16_t) ((tmpValue_h << 8U) | tmpValue_l);
+    /* Clearing SLEEP, writing 0 to RESTART leaves it pending */
+    mode1.bitfield.sleep = 0;
 
-    /* Reading off value */
-    if (PCA9685ReadReg(controllerConf, PCA9685_LED0_OFF_L_REG_ADDR + (channel * 4U), 
-                        (uint8_t *) &tmpValue_l) != PCA9685LIB_SUCCESS)
+    if (mode1.bitfield.restart != 0U)
     {
-        return PCA9685LIB_ERROR;
+        mode1.bitfield.restart = 0;
+
+        if (PCA9685WriteReg(controllerConf, PCA9685_MODE1_REG_ADDR, mode1.regValue) != PCA9685LIB_SUCCESS)
+        {
+            PCA9685Unlock(controllerConf);
+            return PCA9685LIB_ERROR;
+        }
+
+        wakeNs = PCA9685MonotonicNs();
+
+        PCA9685ModeShadowStore(controllerConf, PCA9685_MODE1_REG_ADDR, mode1.regValue);
+
+        PCA9685OscillatorWait(wakeNs);
+
+        /* Writing 1 to RESTART resumes every channel and clears it */
+        mode1.bitfield.restart = 1;
     }
 
-    if (PCA9685ReadReg(controllerConf, PCA9685_LED0_OFF_H_REG_ADDR + (channel * 4U), 
-                        (uint8_t *) &tmpValue_h) != PCA9685LIB_SUCCESS)
+    if (PCA9685WriteReg(controllerConf, PCA9685_MODE1_REG_ADDR, mode1.regValue) != PCA9685LIB_SUCCESS)
     {
+        PCA9685Unlock(controllerConf);
         return PCA9685LIB_ERROR;
     }
 
-    *offValue = (uint16_t) ((tmpValue_h << 8U) | tmpValue_l);
+    PCA9685ModeShadowStore(controllerConf, PCA9685_MODE1_REG_ADDR, mode1.regValue);
+
+    PCA9685Unlock(controllerConf);
 
     return PCA9685LIB_SUCCESS;
 }
 
-int16_t PCA9685_SetPWM(PCA9685I2CConf_t *controllerConf, uint8_t channel, 
-                        uint16_t onValue, uint16_t offValue)
+int16_t PCA9685_Reset(PCA9685I2CConf_t *controllerConf)
 {
-    
-        /* Verifying input */
-        if (controllerConf == NULL)
-        {
-            return PCA9685LIB_ERROR;
-        }
-
-        if (channel > PCA9685_MAX_PWM_CHANNELS)
-        {
-            return PCA9685LIB_ERROR;
-        }
-
-        if (onValue > PCA9685_MAX_PWM_VALUE || offValue > PCA9685_MAX_PWM_VALUE)
-        {
-            return PCA9685LIB_ERROR;
-        }
-    
-        /* Writing on value */
-        if (PCA9685WriteReg(controllerConf, PCA9685_LED0_ON_L_REG_ADDR + (channel * 4U), 
-                            (uint8_t) onValue) != PCA9685LIB_SUCCESS)
-        {
-            return PCA9685LIB_ERROR;
-        }
-    
-        if (PCA9685WriteReg(controllerConf, PCA9685_LED0_ON_H_REG_ADDR + (channel * 4U), 
-                            (uint8_t) (onValue >> 8U)) != PCA9685LIB_SUCCESS)
-        {
-            return PCA9685LIB_ERROR;
-        }
-    
-        /* Writing off value */
-        if (PCA9685WriteReg(controllerConf, PCA9685_LED0_OFF_L_REG_ADDR + (channel * 4U), 
-                            (uint8_t) offValue) != PCA9685LIB_SUCCESS)
-        {
-            return PCA9685LIB_ERROR;
-        }
-    
-        if (PCA9685WriteReg(controllerConf, PCA9685_LED0_OFF_H_REG_ADDR + (channel * 4U), 
-                            (uint8_t) (offValue >> 8U)) != PCA9685LIB_SUCCESS)
-        {
-            return PCA9685LIB_ERROR;
-        }
-    
-        return PCA9685LIB_SUCCESS;
+    return PCA9685_FastResume(controllerConf);
 }
 
-int16_t PCA9685_GetAllPWM(PCA9685I2CConf_t *controllerConf, uint16_t *onValue, 
-                            uint16_t *offValue)
+int16_t PCA9685_Sleep(PCA9685I2CConf_t *controllerConf)
 {
-    uint8_t tmpValue_l = 0U; /** Temporary value to store lowbyte */
-    uint8_t tmpValue_h = 0U; /** Temporary value to store highbyte */
+    PCA9685Mode1Reg_u setBits = {0U}; /** Mode 1 Reg bits to set */
+    PCA9685Mode1Reg_u clearBits = {0U}; /** Mode 1 Reg bits to clear */
+    int16_t status = PCA9685LIB_SUCCESS; /** Modify status */
 
     /* Verifying input */
-    if (controllerConf == NULL || onValue == NULL || offValue == NULL)
+    if (controllerConf == NULL)
     {
         return PCA9685LIB_ERROR;
     }
 
-    /* Reading on value */
-    if (PCA9685ReadReg(controllerConf, PCA9685_ALL_LED_ON_L_REG_ADDR, 
-                        (uint8_t *) &tmpValue_l) != PCA9685LIB_SUCCESS)
-    {
-        return PCA9685LIB_ERROR;
-    }
+    /** Setting sleep bit */
+    setBits.bitfield.sleep = 1;
 
-    if (PCA9685ReadReg(controllerConf, PCA9685_ALL_LED_ON_H_REG_ADDR, 
-                        (uint8_t *) &tmpValue_h) != PCA9685LIB_SUCCESS)
-    {
-        return PCA9685LIB_ERROR;
-    }
+    PCA9685Lock(controllerConf);
 
-    *onValue = (uint16_t) ((tmpValue_h << 8U) | tmpValue_l);
+    /* Sleeps requested by the application are not undone by later writes */
+    controllerConf->autoSlept = 0U;
 
-    /* Reading off value */
-    if (PCA9685ReadReg(controllerConf, PCA9685_ALL_LED_OFF_L_REG_ADDR, 
-                        (uint8_t *) &tmpValue_l) != PCA9685LIB_SUCCESS)
-    {
-        return PCA9685LIB_ERROR;
-    }
+    status = PCA9685ModifyReg(controllerConf, PCA9685_MODE1_REG_ADDR, 
+                                clearBits.regValue, setBits.regValue);
+
+    PCA9685Unlock(controllerConf);
+
+    return status;
+}
+
+int16_t PCA9685_WakeUp(PCA9685I2CConf_t *controllerConf)
+{
+    PCA9685Mode1Reg_u setBits = {0U}; /** Mode 1 Reg bits to set */
+    PCA9685Mode1Reg_u clearBits = {0U}; /** Mode 1 Reg bits to clear */
 
-    if (PCA9685ReadReg(controllerConf, PCA9685_ALL_LED_OFF_H_REG_ADDR, 
-                        (uint8_t *) &tmpValue_h) != PCA9685LIB_SUCCESS)
+    /* Verifying input */
+    if (controllerConf == NULL)
     {
         return PCA9685LIB_ERROR;
     }
 
-    *offValue = (uint16_t) ((tmpValue_h << 8U) | tmpValue_l);
+    /** Clearing sleep bit */
+    clearBits.bitfield.sleep = 1;
 
-    return PCA9685LIB_SUCCESS;
+    return PCA9685ModifyReg(controllerConf, PCA9685_MODE1_REG_ADDR, 
+                            clearBits.regValue, setBits.regValue);
 }
 
-int16_t PCA9685_SetAllPWM(PCA9685I2CConf_t *controllerConf, uint16_t onValue, 
-                            uint16_t offValue)
+int16_t PCA9685_EnableOutput(PCA9685I2CConf_t *controllerConf)
 {
-        
+    PCA9685Mode2Reg_u setBits = {0U}; /** Mode 2 Reg bits to set */
+    PCA9685Mode2Reg_u clearBits = {0U}; /** Mode 2 Reg bits to clear */
+
     /* Verifying input */
     if (controllerConf == NULL)
     {
         return PCA9685LIB_ERROR;
     }
 
-    if (onValue > PCA9685_MAX_PWM_VALUE || offValue > PCA9685_MAX_PWM_VALUE)
+    /** Clearing OE bits */
+    clearBits.bitfield.outne = 3;
+
+    return PCA9685ModifyReg(controllerConf, PCA9685_MODE2_REG_ADDR, 
+                            clearBits.regValue, setBits.regValue);
+}
+
+int16_t PCA9685_DisableOutput(PCA9685I2CConf_t *controllerConf)
+{
+    PCA9685Mode2Reg_u setBits = {0U}; /** Mode 2 Reg bits to set */
+    PCA9685Mode2Reg_u clearBits = {0U}; /** Mode 2 Reg bits to clear */
+
+    /* Verifying input */
+    if (controllerConf == NULL)
     {
         return PCA9685LIB_ERROR;
     }
 
-    /* Writing on value */
-    if (PCA9685WriteReg(controllerConf, PCA9685_ALL_LED_ON_L_REG_ADDR, 
-                        (uint8_t) onValue) != PCA9685LIB_SUCCESS)
+    /** Setting OE bits */
+    setBits.bitfield.outne = 3;
+
+    return PCA9685ModifyReg(controllerConf, PCA9685_MODE2_REG_ADDR, 
+                            clearBits.regValue, setBits.regValue);
+}
+
+int16_t PCA9685_SetOutputInversion(PCA9685I2CConf_t *controllerConf, uint8_t invrt)
+{
+    PCA9685Mode2Reg_u setBits = {0U}; /** Mode 2 Reg bits to set */
+    PCA9685Mode2Reg_u clearBits = {0U}; /** Mode 2 Reg bits to clear */
+
+    /* Verifying input */
+    if (controllerConf == NULL)
     {
         return PCA9685LIB_ERROR;
     }
 
-    if (PCA9685WriteReg(controllerConf, PCA9685_ALL_LED_ON_H_REG_ADDR, 
-                        (uint8_t) (onValue >> 8U)) != PCA9685LIB_SUCCESS)
+    /** Setting INVRT bits */
+    clearBits.bitfield.invrt = 1;
+    setBits.bitfield.invrt = invrt;
+
+    return PCA9685ModifyReg(controllerConf, PCA9685_MODE2_REG_ADDR, 
+                            clearBits.regValue, setBits.regValue);
+}
+
+int16_t PCA9685_SetThreadSafe(PCA9685I2CConf_t *controllerConf, uint8_t enable)
+{
+
+    /* Verifying input */
+    if (controllerConf == NULL)
     {
         return PCA9685LIB_ERROR;
     }
 
-    /* Writing off value */
-    if (PCA9685WriteReg(controllerConf, PCA9685_ALL_LED_OFF_L_REG_ADDR, 
-                        (uint8_t) offValue) != PCA9685LIB_SUCCESS)
+    if (enable != 0U && controllerConf->busLock == NULL)
     {
-        return PCA9685LIB_ERROR;
-    }
+        controllerConf->busLock = PCA9685BusLockGet(controllerConf->i2cDevNumber);
 
-    if (PCA9685WriteReg(controllerConf, PCA9685_ALL_LED_OFF_H_REG_ADDR, 
-                        (uint8_t) (offValue >> 8U)) != PCA9685LIB_SUCCESS)
+        if (controllerConf->busLock == NULL)
+        {
+            return PCA9685LIB_ERROR;
+        }
+    }
+    else if (enable == 0U && controllerConf->busLock != NULL)
     {
-        return PCA9685LIB_ERROR;
+        PCA9685BusLockPut(controllerConf->busLock);
+        controllerConf->busLock = NULL;
     }
 
     return PCA9685LIB_SUCCESS;
 }
 
-int16_t PCA9685_Reset(PCA9685I2CConf_t *controllerConf)
+int16_t PCA9685_GetLockStats(PCA9685I2CConf_t *controllerConf, PCA9685LockStats_t *stats)
 {
-    PCA9685Mode1Reg_u mode1RegRead = {0U}; /** Mode 1 Reg current value */
 
     /* Verifying input */
-    if (controllerConf == NULL)
+    if (controllerConf == NULL || controllerConf->busLock == NULL || stats == NULL)
     {
         return PCA9685LIB_ERROR;
     }
 
-    /* Reading MODE1 Reg first */
-    if (PCA9685ReadReg(controllerConf, PCA9685_MODE1_REG_ADDR, (uint8_t *) &mode1RegRead.regValue) != PCA9685LIB_SUCCESS)
-    {
-        return PCA9685LIB_ERROR;
-    }
+    PCA9685BusLockStats(controllerConf->busLock, stats, 0U);
 
-    /** Setting reset bit */
-    mode1RegRead.bitfield.restart = 1;
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_ResetLockStats(PCA9685I2CConf_t *controllerConf)
+{
+    PCA9685LockStats_t stats; /** Statistics before the reset */
 
-    /* Writing reset command */
-    if (PCA9685WriteReg(controllerConf, PCA9685_MODE1_REG_ADDR, mode1RegRead.regValue) != PCA9685LIB_SUCCESS)
+    /* Verifying input */
+    if (controllerConf == NULL || controllerConf->busLock == NULL)
     {
         return PCA9685LIB_ERROR;
     }
 
+    PCA9685BusLockStats(controllerConf->busLock, &stats, 1U);
+
     return PCA9685LIB_SUCCESS;
 }
 
-int16_t PCA9685_Sleep(PCA9685I2CConf_t *controllerConf)
+int16_t PCA9685_SetBusTimeout(uint16_t i2cDevNumber, uint32_t timeoutMs, uint32_t retries)
 {
-    PCA9685Mode1Reg_u mode1RegRead = {0U}; /** Mode 1 Reg current value */
+    char path[32]; /** Adapter dev path */
+    unsigned long timeout = 0UL; /** Timeout, in I2C_TIMEOUT units */
+    int fd = -1; /** Adapter descriptor */
+    int16_t status = PCA9685LIB_SUCCESS; /** Configuration status */
 
-    /* Verifying input */
-    if (controllerConf == NULL)
+    timeout = (timeoutMs + PCA9685_I2C_TIMEOUT_UNIT_MS - 1U) / PCA9685_I2C_TIMEOUT_UNIT_MS;
+
+    (void) snprintf(path, sizeof(path), "/dev/i2c-%u", (unsigned int) i2cDevNumber);
+
+    /* Adapter settings, any descriptor of the bus sets them for all */
+    fd = open(path, O_RDWR | O_CLOEXEC);
+
+    if (fd < 0)
     {
         return PCA9685LIB_ERROR;
     }
 
-    /* Reading MODE1 Reg first */
-    if (PCA9685ReadReg(controllerConf, PCA9685_MODE1_REG_ADDR, (uint8_t *) &mode1RegRead.regValue) != PCA9685LIB_SUCCESS)
+    if (ioctl(fd, I2C_TIMEOUT, timeout) < 0 || ioctl(fd, I2C_RETRIES, (unsigned long) retries) < 0)
     {
-        return PCA9685LIB_ERROR;
+        status = PCA9685LIB_ERROR;
     }
 
-    /** Setting sleep bit */
-    mode1RegRead.bitfield.sleep = 1;
+    close(fd);
+
+    return status;
+}
 
-    /* Writing sleep command */
-    if (PCA9685WriteReg(controllerConf, PCA9685_MODE1_REG_ADDR, mode1RegRead.regValue) != PCA9685LIB_SUCCESS)
+int16_t PCA9685_GetHealth(const PCA9685I2CConf_t *controllerConf, PCA9685Health_t *health)
+{
+
+    /* Verifying input */
+    if (controllerConf == NULL || health == NULL)
     {
         return PCA9685LIB_ERROR;
     }
 
+    *health = controllerConf->health;
+
     return PCA9685LIB_SUCCESS;
 }
 
-int16_t PCA9685_WakeUp(PCA9685I2CConf_t *controllerConf)
+int16_t PCA9685_GetLastError(const PCA9685I2CConf_t *controllerConf, PCA9685Error_t *error)
 {
-    PCA9685Mode1Reg_u mode1RegRead = {0U}; /** Mode 1 Reg current value */
 
     /* Verifying input */
-    if (controllerConf == NULL)
+    if (controllerConf == NULL || error == NULL)
     {
         return PCA9685LIB_ERROR;
     }
 
-    /* Reading MODE1 Reg first */
-    if (PCA9685ReadReg(controllerConf, PCA9685_MODE1_REG_ADDR, (uint8_t *) &mode1RegRead.regValue) != PCA9685LIB_SUCCESS)
-    {
-        return PCA9685LIB_ERROR;
-    }
+    *error = controllerConf->lastError;
 
-    /** Clearing sleep bit */
-    mode1RegRead.bitfield.sleep = 0;
+    return PCA9685LIB_SUCCESS;
+}
 
-    /* Writing wake up command */
-    if (PCA9685WriteReg(controllerConf, PCA9685_MODE1_REG_ADDR, mode1RegRead.regValue) != PCA9685LIB_SUCCESS)
+int16_t PCA9685_ClearLastError(PCA9685I2CConf_t *controllerConf)
+{
+
+    /* Verifying input */
+    if (controllerConf == NULL)
     {
         return PCA9685LIB_ERROR;
     }
 
+    memset(&controllerConf->lastError, 0, sizeof(controllerConf->lastError));
+
     return PCA9685LIB_SUCCESS;
 }
 
-int16_t PCA9685_EnableOutput(PCA9685I2CConf_t *controllerConf)
+int16_t PCA9685_SetRetryPolicy(PCA9685I2CConf_t *controllerConf, const PCA9685RetryPolicy_t *policy)
 {
-    PCA9685Mode2Reg_u mode2RegRead = {0U}; /** Mode 2 Reg current value */
 
     /* Verifying input */
-    if (controllerConf == NULL)
+    if (controllerConf == NULL || policy == NULL)
     {
         return PCA9685LIB_ERROR;
     }
 
-    /* Reading MODE2 Reg first */
-    if (PCA9685ReadReg(controllerConf, PCA9685_MODE2_REG_ADDR, (uint8_t *) &mode2RegRead.regValue) != PCA9685LIB_SUCCESS)
-    {
-        return PCA9685LIB_ERROR;
-    }
+    PCA9685Lock(controllerConf);
 
-    /** Clearing OE bits */
-    mode2RegRead.bitfield.outne = 0;
+    controllerConf->retryPolicy = *policy;
 
-    /* Writing enable output command */
-    if (PCA9685WriteReg(controllerConf, PCA9685_MODE1_REG_ADDR, mode2RegRead.regValue) != PCA9685LIB_SUCCESS)
-    {
-        return PCA9685LIB_ERROR;
-    }
+    PCA9685Unlock(controllerConf);
 
     return PCA9685LIB_SUCCESS;
 }
 
-int16_t PCA9685_DisableOutput(PCA9685I2CConf_t *controllerConf)
+uint8_t PCA9685_IsQuarantined(const PCA9685I2CConf_t *controllerConf)
 {
-    PCA9685Mode2Reg_u mode2RegRead = {0U}; /** Mode 2 Reg current value */
 
     /* Verifying input */
-    if (controllerConf == NULL)
+    if (controllerConf == NULL || controllerConf->health.backoffMs == 0U)
     {
-        return PCA9685LIB_ERROR;
+        return 0U;
     }
 
-    /* Reading MODE2 Reg first */
-    if (PCA9685ReadReg(controllerConf, PCA9685_MODE2_REG_ADDR, (uint8_t *) &mode2RegRead.regValue) != PCA9685LIB_SUCCESS)
-    {
-        return PCA9685LIB_ERROR;
-    }
+    return (uint8_t) (PCA9685MonotonicNs() < controllerConf->health.retryAtNs);
+}
 
-    /** Setting OE bits */
-    mode2RegRead.bitfield.outne = 3;
+int16_t PCA9685_SetAutoSleep(PCA9685I2CConf_t *controllerConf, uint32_t idleMs)
+{
 
-    /* Writing disable output command */
-    if (PCA9685WriteReg(controllerConf, PCA9685_MODE1_REG_ADDR, mode2RegRead.regValue) != PCA9685LIB_SUCCESS)
+    /* Verifying input */
+    if (controllerConf == NULL)
     {
         return PCA9685LIB_ERROR;
     }
 
+    PCA9685Lock(controllerConf);
+
+    /* Idle time is counted from now on */
+    controllerConf->autoSleepMs = idleMs;
+    controllerConf->lastWriteNs = PCA9685MonotonicNs();
+
+    PCA9685Unlock(controllerConf);
+
     return PCA9685LIB_SUCCESS;
 }
 
-int16_t PCA9685_SetOutputInversion(PCA9685I2CConf_t *controllerConf, uint8_t invrt)
+int16_t PCA9685_AutoSleepPoll(PCA9685I2CConf_t *controllerConf)
 {
-    PCA9685Mode2Reg_u mode2RegRead = {0U}; /** Mode 2 Reg current value */
+    PCA9685Mode1Reg_u mode1 = {0U}; /** MODE1 value */
+    uint8_t channel = 0U; /** Channel index */
+    int16_t status = PCA9685LIB_SUCCESS; /** Sleep status */
 
     /* Verifying input */
     if (controllerConf == NULL)
@@ -586,26 +2632,59 @@ int16_t PCA9685_SetOutputInversion(PCA9685I2CConf_t *controllerConf, uint8_t inv
         return PCA9685LIB_ERROR;
     }
 
-    /* Reading MODE2 Reg first */
-    if (PCA9685ReadReg(controllerConf, PCA9685_MODE2_REG_ADDR, (uint8_t *) &mode2RegRead.regValue) != PCA9685LIB_SUCCESS)
+    PCA9685Lock(controllerConf);
+
+    mode1.regValue = controllerConf->mode1Shadow;
+
+    /* Sleeping controllers and controllers in an unknown state are left alone */
+    if (controllerConf->autoSleepMs == 0U || controllerConf->shadowValid != 0xFFFFU 
+            || (controllerConf->modeShadowValid & PCA9685_MODE1_SHADOW_VALID) == 0U 
+            || mode1.bitfield.sleep != 0U 
+            || (PCA9685MonotonicNs() - controllerConf->lastWriteNs) 
+                < ((uint64_t) controllerConf->autoSleepMs * 1000000U))
     {
-        return PCA9685LIB_ERROR;
+        PCA9685Unlock(controllerConf);
+        return PCA9685LIB_SUCCESS;
     }
 
-    /** Setting INVRT bits */
-    mode2RegRead.bitfield.invrt = invrt;
+    /* Sleeping stops the outputs, only controllers with every channel off are put to sleep */
+    for (channel = 0U; channel < PCA9685_MAX_PWM_CHANNELS; channel++)
+    {
+        if (PCA9685RegsToDuty(&controllerConf->ledShadow[channel * 4U]) != 0)
+        {
+            PCA9685Unlock(controllerConf);
+            return PCA9685LIB_SUCCESS;
+        }
+    }
 
-    /* Writing set output inversion command */
-    if (PCA9685WriteReg(controllerConf, PCA9685_MODE1_REG_ADDR, mode2RegRead.regValue) != PCA9685LIB_SUCCESS)
+    status = PCA9685_Sleep(controllerConf);
+
+    if (status == PCA9685LIB_SUCCESS)
     {
-        return PCA9685LIB_ERROR;
+        controllerConf->autoSlept = 1U;
     }
 
-    return PCA9685LIB_SUCCESS;
+    PCA9685Unlock(controllerConf);
+
+    return status;
+}
+
+uint8_t PCA9685_IsAutoSlept(const PCA9685I2CConf_t *controllerConf)
+{
+
+    /* Verifying input */
+    if (controllerConf == NULL)
+    {
+        return 0U;
+    }
+
+    return controllerConf->autoSlept;
 }
 
 int16_t PCA9685_Close(PCA9685I2CConf_t *controllerConf)
 {
+    int16_t status = PCA9685LIB_SUCCESS; /** Close status */
+
     /* Verifying input */
     if (controllerConf == NULL)
     {
@@ -613,10 +2692,17 @@ int16_t PCA9685_Close(PCA9685I2CConf_t *controllerConf)
     }
 
     /* Closing I2C channel */
-    if (i2cClose(&controllerConf->i2cConf) != US_I2C_SUCCESS)
+    status = (i2cClose(&controllerConf->i2cConf) == US_I2C_SUCCESS) ? PCA9685LIB_SUCCESS : PCA9685LIB_ERROR;
+
+    /* Registry slots are released anyway, they would never be reused otherwise */
+    (void) PCA9685_SetThreadSafe(controllerConf, 0U);
+
+    if (controllerConf->costEstimator != NULL)
     {
-        return PCA9685LIB_ERROR;
+        PCA9685BusEstimatorPut(controllerConf->costEstimator);
+        controllerConf->costEstimator = NULL;
+        controllerConf->costCalibration = 0U;
     }
 
-    return PCA9685LIB_SUCCESS;
+    return status;
 }
@@ -0,0 +1,289 @@
+/*
+MIT License
+
+Copyright (c) 2024 Giuseppe Giglio <g.giglio001@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * \file pca9685motion.c
+ * \brief This file contains the definitions of the motion layer that moves
+ *       PCA9685 channels towards target pulse widths along trapezoidal or
+ *       S-curve profiles.
+ */
+
+/* Standard library includes */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* Local includes */
+#include "pca9685motion.h"
+#include "pca9685lib.h"
+
+
+
+/* Unexported functions definitions */
+
+/**
+ * \brief This function limits a value to [-limit, limit].
+ * \param [in] value -- Value to limit.
+ * \param [in] limit -- Non-negative limit.
+ * \returns The limited value.
+ */
+float PCA9685MotionClamp(float value, float limit)
+{
+    return fmaxf(-limit, fminf(limit, value));
+}
+
+/**
+ * \brief This function advances a channel by one tick.
+ *        The reference follows a trapezoidal profile: its velocity is the highest
+ *        one from which the target can still be reached braking at maxAcceleration,
+ *        capped to maxVelocity. The output is the moving average of the reference
+ *        velocity, which bounds jerk for S-curve profiles and lands on the target
+ *        without overshoot. A target moved behind the channel, or too close to
+ *        brake for, is overshot and come back to, acceleration stays limited.
+ * \param [in] axis -- Pointer to the channel motion state.
+ * \returns Non-zero while the channel is still moving.
+ */
+uint8_t PCA9685MotionStep(PCA9685MotionAxis_t *axis)
+{
+    float distance = axis->target - axis->refPosition; /** Remaining reference distance */
+    float accel = axis->maxAcceleration; /** Acceleration limit */
+    float reachable = 0.0f; /** Highest velocity that can still stop on target */
+    float previous = axis->refVelocity; /** Reference velocity of the previous tick */
+
+    if (distance != 0.0f)
+    {
+        /* Discrete braking distance v^2 / 2a + v / 2 solved for v */
+        reachable = (-accel / 2.0f) + sqrtf(((accel * accel) / 4.0f) + (2.0f * accel * fabsf(distance)));
+        reachable = copysignf(fminf(axis->maxVelocity, reachable), distance);
+
+        axis->refVelocity += PCA9685MotionClamp(reachable - axis->refVelocity, accel);
+
+        /* Landing exactly on the target, only if moving towards it within one acceleration step */
+        if ((axis->refVelocity * distance) > 0.0f 
+                && fabsf(axis->refVelocity) >= fabsf(distance) 
+                && fabsf(distance - previous) <= accel)
+        {
+            axis->refVelocity = distance;
+        }
+
+        axis->refPosition += axis->refVelocity;
+    }
+    else
+    {
+        axis->refVelocity = 0.0f;
+    }
+
+    /* Moving average of the reference velocity */
+    axis->smoothSum += axis->refVelocity - axis->smoothRing[axis->smoothIndex];
+    axis->smoothRing[axis->smoothIndex] = axis->refVelocity;
+    axis->smoothIndex = (uint8_t) ((axis->smoothIndex + 1U) % axis->smoothLength);
+    axis->position += axis->smoothSum / (float) axis->smoothLength;
+
+    if (axis->refPosition != axis->target)
+    {
+        axis->settleTicks = 0U;
+        return 1U;
+    }
+
+    /* Once the average has flushed, removing accumulated rounding */
+    if (++axis->settleTicks < axis->smoothLength)
+    {
+        return 1U;
+    }
+
+    axis->position = axis->target;
+    axis->refVelocity = 0.0f;
+    axis->smoothSum = 0.0f;
+    memset(axis->smoothRing, 0, sizeof(axis->smoothRing));
+
+    return 0U;
+}
+
+/* Exported Functions Definitions */
+
+int16_t PCA9685_MotionInit(PCA9685Motion_t *motion, PCA9685I2CConf_t *board, float tickHz)
+{
+    uint8_t channel = 0U; /** Channel index */
+
+    /* Verifying input */
+    if (motion == NULL || board == NULL || !(tickHz > 0.0f))
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    memset(motion, 0, sizeof(PCA9685Motion_t));
+
+    motion->board = board;
+    motion->tickHz = tickHz;
+
+    for (channel = 0U; channel < PCA9685_MAX_PWM_CHANNELS; channel++)
+    {
+        motion->axes[channel].maxVelocity = (float) PCA9685_MAX_PWM_VALUE;
+        motion->axes[channel].maxAcceleration = (float) PCA9685_MAX_PWM_VALUE;
+        motion->axes[channel].smoothLength = 1U;
+    }
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_MotionSetLimits(PCA9685Motion_t *motion, uint8_t channel, uint8_t profile, 
+                                float maxVelocity, float maxAcceleration, float maxJerk)
+{
+    PCA9685MotionAxis_t *axis = NULL; /** Channel motion state */
+    float velocity = 0.0f; /** Current output velocity */
+    float length = 1.0f; /** Moving average length */
+    uint8_t index = 0U; /** Ring index */
+
+    /* Verifying input */
+    if (motion == NULL || channel >= PCA9685_MAX_PWM_CHANNELS || profile > PCA9685_MOTION_SCURVE)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (!(maxVelocity > 0.0f) || !(maxAcceleration > 0.0f) 
+            || (profile == PCA9685_MOTION_SCURVE && !(maxJerk > 0.0f)))
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    axis = &motion->axes[channel];
+
+    /* Converting limits to per tick units */
+    axis->maxVelocity = maxVelocity / motion->tickHz;
+    axis->maxAcceleration = maxAcceleration / (motion->tickHz * motion->tickHz);
+
+    if (profile == PCA9685_MOTION_SCURVE)
+    {
+        length = ceilf((maxAcceleration / maxJerk) * motion->tickHz);
+        length = fmaxf(1.0f, fminf((float) PCA9685_MOTION_MAX_SMOOTH, length));
+    }
+
+    /* Refilling the average so that the output velocity stays continuous */
+    velocity = axis->smoothSum / (float) axis->smoothLength;
+    axis->smoothLength = (uint8_t) length;
+    axis->smoothIndex = 0U;
+    axis->smoothSum = velocity * (float) axis->smoothLength;
+
+    for (index = 0U; index < PCA9685_MOTION_MAX_SMOOTH; index++)
+    {
+        axis->smoothRing[index] = (index < axis->smoothLength) ? velocity : 0.0f;
+    }
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_MotionSetPosition(PCA9685Motion_t *motion, uint8_t channel, uint16_t position)
+{
+    PCA9685MotionAxis_t *axis = NULL; /** Channel motion state */
+
+    /* Verifying input */
+    if (motion == NULL || channel >= PCA9685_MAX_PWM_CHANNELS || position > PCA9685_MAX_PWM_VALUE)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    axis = &motion->axes[channel];
+
+    axis->target = (float) position;
+    axis->refPosition = (float) position;
+    axis->refVelocity = 0.0f;
+    axis->position = (float) position;
+    axis->smoothSum = 0.0f;
+    axis->settleTicks = 0U;
+    memset(axis->smoothRing, 0, sizeof(axis->smoothRing));
+
+    /* Written on the next tick */
+    axis->output = position;
+    motion->movingMask &= (uint16_t) ~(1U << channel);
+    (void) PCA9685_FrameSetDuty(&motion->frame, channel, position);
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_MotionSetTarget(PCA9685Motion_t *motion, uint8_t channel, uint16_t target)
+{
+
+    /* Verifying input */
+    if (motion == NULL || channel >= PCA9685_MAX_PWM_CHANNELS || target > PCA9685_MAX_PWM_VALUE)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    motion->axes[channel].target = (float) target;
+    motion->axes[channel].settleTicks = 0U;
+    motion->movingMask |= (uint16_t) (1U << channel);
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_MotionTick(PCA9685Motion_t *motion)
+{
+    PCA9685MotionAxis_t *axis = NULL; /** Channel motion state */
+    uint16_t moving = 0U; /** Channels left to advance */
+    uint16_t output = 0U; /** Rounded pulse width */
+    uint8_t channel = 0U; /** Channel index */
+
+    /* Verifying input */
+    if (motion == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    moving = motion->movingMask;
+
+    while (moving != 0U)
+    {
+        channel = (uint8_t) __builtin_ctz(moving);
+        moving &= (uint16_t) (moving - 1U);
+        axis = &motion->axes[channel];
+
+        if (PCA9685MotionStep(axis) == 0U)
+        {
+            motion->movingMask &= (uint16_t) ~(1U << channel);
+        }
+
+        output = (uint16_t) fmaxf(0.0f, fminf((float) PCA9685_MAX_PWM_VALUE, axis->position + 0.5f));
+
+        if (output != axis->output)
+        {
+            axis->output = output;
+            (void) PCA9685_FrameSetDuty(&motion->frame, channel, output);
+        }
+    }
+
+    if (motion->frame.channelMask == 0U)
+    {
+        return PCA9685LIB_SUCCESS;
+    }
+
+    if (PCA9685_CommitFrame(motion->board, &motion->frame) != PCA9685LIB_SUCCESS)
+    {
+        /* Pending channels are retried on the next tick */
+        return PCA9685LIB_ERROR;
+    }
+
+    motion->frame.channelMask = 0U;
+
+    return PCA9685LIB_SUCCESS;
+}
@@ -0,0 +1,117 @@
+/*
+MIT License
+
+Copyright (c) 2024 Giuseppe Giglio <g.giglio001@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * \file pca9685proto.c
+ * \brief This file contains the definitions of the pca9685d protocol message
+ *       helpers.
+ */
+
+/* Standard library includes */
+#include <string.h>
+
+/* Local includes */
+#include "pca9685proto.h"
+#include "pca9685lib.h"
+
+
+
+/* Exported Functions Definitions */
+
+size_t PCA9685_ProtoPack(uint8_t *message, const PCA9685ProtoHeader_t *header, 
+                            const PCA9685Frame_t *frame)
+{
+    PCA9685ProtoChannel_t value; /** Channel value */
+    size_t size = sizeof(PCA9685ProtoHeader_t); /** Message size */
+    uint8_t channel = 0U; /** Channel index */
+
+    memcpy(message, header, sizeof(PCA9685ProtoHeader_t));
+
+    if (frame == NULL)
+    {
+        return size;
+    }
+
+    for (channel = 0U; channel < PCA9685_MAX_PWM_CHANNELS; channel++)
+    {
+        if ((header->channelMask & (1U << channel)) != 0U)
+        {
+            value.onValue = frame->onValue[channel];
+            value.offValue = frame->offValue[channel];
+            memcpy(&message[size], &value, sizeof(value));
+            size += sizeof(value);
+        }
+    }
+
+    return size;
+}
+
+int16_t PCA9685_ProtoUnpack(const uint8_t *message, size_t size, PCA9685ProtoHeader_t *header, 
+                            PCA9685Frame_t *frame)
+{
+    PCA9685ProtoChannel_t value; /** Channel value */
+    size_t offset = sizeof(PCA9685ProtoHeader_t); /** Read offset */
+    uint8_t channel = 0U; /** Channel index */
+
+    /* Verifying input */
+    if (message == NULL || header == NULL || frame == NULL || size < sizeof(PCA9685ProtoHeader_t))
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    memcpy(header, message, sizeof(PCA9685ProtoHeader_t));
+    frame->channelMask = 0U;
+
+    if (size == sizeof(PCA9685ProtoHeader_t))
+    {
+        return PCA9685LIB_SUCCESS;
+    }
+
+    if (size != sizeof(PCA9685ProtoHeader_t) 
+                + (size_t) __builtin_popcount(header->channelMask) * sizeof(value))
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    for (channel = 0U; channel < PCA9685_MAX_PWM_CHANNELS; channel++)
+    {
+        if ((header->channelMask & (1U << channel)) != 0U)
+        {
+            memcpy(&value, &message[offset], sizeof(value));
+            offset += sizeof(value);
+
+            if (value.onValue > PCA9685_MAX_PWM_VALUE || value.offValue > PCA9685_MAX_PWM_VALUE)
+            {
+                return PCA9685LIB_ERROR;
+            }
+
+            frame->onValue[channel] = value.onValue;
+            frame->offValue[channel] = value.offValue;
+        }
+    }
+
+    frame->channelMask = header->channelMask;
+
+    return PCA9685LIB_SUCCESS;
+}
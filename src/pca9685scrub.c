@@ -0,0 +1,243 @@
+/*
+MIT License
+
+Copyright (c) 2024 Giuseppe Giglio <g.giglio001@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * \file pca9685scrub.c
+ * \brief This file contains the definitions of the state scrubber, which
+ *       verifies the boards against their shadow copy a slice at a time, within
+ *       a bus-time budget.
+ */
+
+/* Standard library includes */
+#include <string.h>
+
+/* Local includes */
+#include "pca9685scrub.h"
+#include "pca9685lib.h"
+#include "pca9685buslock.h"
+
+
+/* Unexported functions definitions */
+
+/**
+ * \brief This function moves the scrubber to the next board.
+ * \param [in] scrubber -- Pointer to the scrubber.
+ */
+void PCA9685ScrubNextBoard(PCA9685Scrubber_t *scrubber)
+{
+    scrubber->channel = 0U;
+    scrubber->board = (scrubber->board + 1U) % scrubber->boardCount;
+}
+
+/**
+ * \brief This function verifies the next slice. The first slice of a board
+ *        also checks MODE1, and restores the whole board if its state is lost.
+ * \param [in] scrubber -- Pointer to the scrubber.
+ * \param [out] repaired -- NULL, or the per-board repaired channels.
+ * \returns PCA9685LIB_SUCCESS if the slice is successfully verified, otherwise PCA9685LIB_ERROR.
+ */
+int16_t PCA9685ScrubSlice(PCA9685Scrubber_t *scrubber, uint16_t *repaired)
+{
+    PCA9685I2CConf_t *board = scrubber->boards[scrubber->board]; /** Board of the slice */
+    uint32_t mask = 0U; /** Channels of the slice */
+    uint16_t mismatched = 0U; /** Channels found corrupted */
+    uint8_t stateLost = 0U; /** Non-zero if the board lost its state */
+
+    /* Quarantined boards are left to the flushes that retry them */
+    if (PCA9685_IsQuarantined(board) != 0U)
+    {
+        PCA9685ScrubNextBoard(scrubber);
+        return PCA9685LIB_SUCCESS;
+    }
+
+    scrubber->stats.slices++;
+
+    if (scrubber->channel == 0U)
+    {
+        if (PCA9685_CheckState(board, &stateLost) != PCA9685LIB_SUCCESS)
+        {
+            scrubber->stats.errors++;
+            PCA9685ScrubNextBoard(scrubber);
+            return PCA9685LIB_ERROR;
+        }
+
+        if (stateLost != 0U)
+        {
+            if (repaired != NULL)
+            {
+                repaired[scrubber->board] = PCA9685_SCRUB_RESTORED;
+            }
+
+            PCA9685ScrubNextBoard(scrubber);
+
+            if (PCA9685_RestoreState(board) != PCA9685LIB_SUCCESS)
+            {
+                scrubber->stats.errors++;
+                return PCA9685LIB_ERROR;
+            }
+
+            scrubber->stats.restores++;
+            return PCA9685LIB_SUCCESS;
+        }
+    }
+
+    mask = ((1U << scrubber->sliceChannels) - 1U) << scrubber->channel;
+
+    if (PCA9685_ScrubChannels(board, (uint16_t) mask, &mismatched) != PCA9685LIB_SUCCESS)
+    {
+        scrubber->stats.errors++;
+        PCA9685ScrubNextBoard(scrubber);
+        return PCA9685LIB_ERROR;
+    }
+
+    scrubber->stats.repairedChannels += (uint64_t) __builtin_popcount(mismatched);
+
+    if (repaired != NULL)
+    {
+        repaired[scrubber->board] |= mismatched;
+    }
+
+    scrubber->channel = (uint8_t) (scrubber->channel + scrubber->sliceChannels);
+
+    if (scrubber->channel >= PCA9685_MAX_PWM_CHANNELS)
+    {
+        scrubber->stats.passes++;
+        PCA9685ScrubNextBoard(scrubber);
+    }
+
+    return PCA9685LIB_SUCCESS;
+}
+
+
+/* Exported Functions Definitions */
+
+int16_t PCA9685_ScrubInit(PCA9685Scrubber_t *scrubber, uint8_t sliceChannels, uint32_t budgetNs)
+{
+
+    /* Verifying input */
+    if (scrubber == NULL || sliceChannels == 0U || sliceChannels > PCA9685_MAX_PWM_CHANNELS)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    memset(scrubber, 0, sizeof(*scrubber));
+
+    scrubber->sliceChannels = sliceChannels;
+    scrubber->budgetNs = budgetNs;
+    scrubber->lastNs = PCA9685MonotonicNs();
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_ScrubAddBoard(PCA9685Scrubber_t *scrubber, PCA9685I2CConf_t *board)
+{
+
+    /* Verifying input */
+    if (scrubber == NULL || board == NULL || scrubber->boardCount >= PCA9685_SCRUB_MAX_BOARDS)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    scrubber->boards[scrubber->boardCount] = board;
+    scrubber->boardCount++;
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_ScrubTick(PCA9685Scrubber_t *scrubber, uint16_t *repaired)
+{
+    uint64_t now = 0U; /** Current time */
+    uint64_t start = 0U; /** Slice start time */
+    uint64_t elapsed = 0U; /** Time since the last refill, then slice duration */
+    int64_t depth = 0; /** Bucket depth */
+    uint32_t slices = 0U; /** Slices verified during this tick */
+    uint32_t maxSlices = 0U; /** One pass over every board */
+    int16_t status = PCA9685LIB_SUCCESS; /** Tick status */
+
+    /* Verifying input */
+    if (scrubber == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (repaired != NULL)
+    {
+        memset(repaired, 0, scrubber->boardCount * sizeof(*repaired));
+    }
+
+    now = PCA9685MonotonicNs();
+    elapsed = now - scrubber->lastNs;
+    scrubber->lastNs = now;
+
+    /* The bucket is never deeper than a second of budget */
+    if (elapsed > 1000000000U)
+    {
+        elapsed = 1000000000U;
+    }
+
+    depth = (int64_t) (scrubber->budgetNs / PCA9685_SCRUB_BURST_DIVIDER);
+    scrubber->tokensNs += (int64_t) ((elapsed * scrubber->budgetNs) / 1000000000U);
+
+    if (scrubber->tokensNs > depth)
+    {
+        scrubber->tokensNs = depth;
+    }
+
+    maxSlices = scrubber->boardCount 
+                * ((PCA9685_MAX_PWM_CHANNELS + scrubber->sliceChannels - 1U) / scrubber->sliceChannels);
+
+    /* A slice is started while some budget is left, its actual cost is charged after */
+    while (scrubber->tokensNs > 0 && slices < maxSlices)
+    {
+        start = PCA9685MonotonicNs();
+
+        if (PCA9685ScrubSlice(scrubber, repaired) != PCA9685LIB_SUCCESS)
+        {
+            status = PCA9685LIB_ERROR;
+        }
+
+        slices++;
+
+        elapsed = PCA9685MonotonicNs() - start;
+
+        scrubber->tokensNs -= (int64_t) elapsed;
+        scrubber->stats.busNs += elapsed;
+    }
+
+    return status;
+}
+
+int16_t PCA9685_ScrubGetStats(const PCA9685Scrubber_t *scrubber, PCA9685ScrubStats_t *stats)
+{
+
+    /* Verifying input */
+    if (scrubber == NULL || stats == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    *stats = scrubber->stats;
+
+    return PCA9685LIB_SUCCESS;
+}
@@ -0,0 +1,136 @@
+/*
+MIT License
+
+Copyright (c) 2024 Giuseppe Giglio <g.giglio001@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * \file pca9685seqlock.h
+ * \brief This file contains the sequence lock helpers shared by the library
+ *       modules. Not part of the public interface.
+ *
+ * The sequence counter is even while the protected data is stable and odd
+ * while a writer updates it. Readers copy the data without locking and retry
+ * if the counter changed meanwhile.
+ */
+
+#ifndef PCA9685SEQLOCK_H
+#define PCA9685SEQLOCK_H
+
+/* Standard library includes */
+#include <stdint.h>
+
+/* Macros */
+
+/* Number of attempts before a reader or writer gives up */
+#define PCA9685_SEQLOCK_SPINS (1000U)
+
+
+/* Functions definitions */
+
+/**
+ * \brief This function starts a read section.
+ * \param [in] seq -- Pointer to the sequence counter.
+ * \param [out] start -- Sequence value to pass to PCA9685SeqReadRetry.
+ * \returns Non-zero if the read section is started, zero if a writer held
+ *          the lock for PCA9685_SEQLOCK_SPINS attempts.
+ */
+static inline uint8_t PCA9685SeqReadBegin(const uint32_t *seq, uint32_t *start)
+{
+    uint32_t spins = 0U; /** Attempts so far */
+
+    for (spins = 0U; spins < PCA9685_SEQLOCK_SPINS; spins++)
+    {
+        *start = __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+
+        if ((*start & 1U) == 0U)
+        {
+            return 1U;
+        }
+    }
+
+    return 0U;
+}
+
+/**
+ * \brief This function ends a read section.
+ * \param [in] seq -- Pointer to the sequence counter.
+ * \param [in] start -- Sequence value returned by PCA9685SeqReadBegin.
+ * \returns Non-zero if a writer ran meanwhile and the data must be read again.
+ */
+static inline uint8_t PCA9685SeqReadRetry(const uint32_t *seq, uint32_t start)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    return (__atomic_load_n(seq, __ATOMIC_RELAXED) != start) ? 1U : 0U;
+}
+
+/**
+ * \brief This function starts a write section on a counter that has a single
+ *        writer, or whose writers are serialized by the caller.
+ * \param [in] seq -- Pointer to the sequence counter.
+ */
+static inline void PCA9685SeqWriteBegin(uint32_t *seq)
+{
+    __atomic_store_n(seq, __atomic_load_n(seq, __ATOMIC_RELAXED) + 1U, __ATOMIC_RELAXED);
+
+    /* Data stores must not become visible before the odd counter */
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/**
+ * \brief This function tries to start a write section. Writers exclude each
+ *        other by moving the counter from even to odd.
+ * \param [in] seq -- Pointer to the sequence counter.
+ * \returns Non-zero if the write section is started.
+ */
+static inline uint8_t PCA9685SeqTryWriteBegin(uint32_t *seq)
+{
+    uint32_t spins = 0U; /** Attempts so far */
+    uint32_t value = 0U; /** Observed sequence value */
+
+    for (spins = 0U; spins < PCA9685_SEQLOCK_SPINS; spins++)
+    {
+        value = __atomic_load_n(seq, __ATOMIC_RELAXED);
+
+        if ((value & 1U) == 0U 
+                && __atomic_compare_exchange_n(seq, &value, value + 1U, 0, 
+                                                __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        {
+            /* Data stores must not become visible before the odd counter */
+            __atomic_thread_fence(__ATOMIC_RELEASE);
+            return 1U;
+        }
+    }
+
+    return 0U;
+}
+
+/**
+ * \brief This function ends a write section.
+ * \param [in] seq -- Pointer to the sequence counter.
+ */
+static inline void PCA9685SeqWriteEnd(uint32_t *seq)
+{
+    __atomic_fetch_add(seq, 1U, __ATOMIC_RELEASE);
+}
+
+#endif // PCA9685SEQLOCK_H
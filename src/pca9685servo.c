@@ -0,0 +1,277 @@
+/*
+MIT License
+
+Copyright (c) 2024 Giuseppe Giglio <g.giglio001@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * \file pca9685servo.c
+ * \brief This file contains the definitions of the servo abstraction over a
+ *       PCA9685 channel, with per-channel calibration tables.
+ */
+
+/* Standard library includes */
+#include <stdlib.h>
+#include <string.h>
+
+/* Local includes */
+#include "pca9685servo.h"
+#include "pca9685lib.h"
+
+
+
+/* Unexported functions definitions */
+
+/**
+ * \brief This function rebuilds the angle-to-ticks lookup table of a servo for
+ *        the current prescaler of its board, read back from the board when it
+ *        is not known yet.
+ *        One PWM count lasts (prescaler + 1) / 25 us with the internal oscillator.
+ * \param [in] servo -- Pointer to the servo.
+ * \returns PCA9685LIB_SUCCESS if the table is successfully built, otherwise PCA9685LIB_ERROR.
+ */
+int16_t PCA9685ServoBuildLut(PCA9685Servo_t *servo)
+{
+    uint8_t prescaler = servo->board->prescaler; /** Board prescaler */
+    uint8_t node = 0U; /** Lookup table node */
+    int32_t pulseUs = 0; /** Trimmed pulse width */
+
+    if ((servo->board->modeShadowValid & PCA9685_PRESCALER_SHADOW_VALID) == 0U 
+        && PCA9685_GetPrescaler(servo->board, &prescaler) != PCA9685LIB_SUCCESS)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    for (node = 0U; node < PCA9685_SERVO_LUT_SIZE; node++)
+    {
+        pulseUs = (int32_t) servo->pulseUs[(servo->direction < 0) 
+                                            ? (PCA9685_SERVO_LUT_SIZE - 1U - node) : node] 
+                    + servo->trimUs;
+
+        if (pulseUs < 0)
+        {
+            pulseUs = 0;
+        }
+
+        servo->lutTicks[node] = (uint32_t) ((((uint64_t) pulseUs * (PCA9685_INT_CLOCK_FREQ / 1000000U)) 
+                                                << PCA9685_SERVO_LUT_FRAC_BITS) / (prescaler + 1U));
+    }
+
+    servo->lutPrescaler = prescaler;
+    servo->lutValid = 1U;
+
+    return PCA9685LIB_SUCCESS;
+}
+
+/* Exported Functions Definitions */
+
+int16_t PCA9685_ServoInit(PCA9685Servo_t *servo, PCA9685I2CConf_t *board, uint8_t channel, 
+                            uint16_t minPulseUs, uint16_t maxPulseUs, uint16_t rangeDeg)
+{
+    uint8_t node = 0U; /** Calibration node */
+
+    /* Verifying input */
+    if (servo == NULL || board == NULL || channel >= PCA9685_MAX_PWM_CHANNELS)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    /* Angles are stored in tenths of a degree on 16 bits */
+    if (rangeDeg == 0U || rangeDeg > PCA9685_SERVO_MAX_RANGE_DEG || minPulseUs > maxPulseUs)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    memset(servo, 0, sizeof(PCA9685Servo_t));
+
+    servo->board = board;
+    servo->channel = channel;
+    servo->direction = 1;
+    servo->rangeDeg = rangeDeg;
+
+    for (node = 0U; node < PCA9685_SERVO_LUT_SIZE; node++)
+    {
+        servo->pulseUs[node] = (uint16_t) (minPulseUs 
+                                + (((uint32_t) (maxPulseUs - minPulseUs) * node) / (PCA9685_SERVO_LUT_SIZE - 1U)));
+    }
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_ServoSetCalibration(PCA9685Servo_t *servo, const uint16_t *pulseUs)
+{
+
+    /* Verifying input */
+    if (servo == NULL || pulseUs == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    memcpy(servo->pulseUs, pulseUs, sizeof(servo->pulseUs));
+    servo->lutValid = 0U;
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_ServoSetTrim(PCA9685Servo_t *servo, int16_t trimUs, int8_t direction)
+{
+
+    /* Verifying input */
+    if (servo == NULL || (direction != 1 && direction != -1))
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    servo->trimUs = trimUs;
+    servo->direction = direction;
+    servo->lutValid = 0U;
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_ServoAngleToTicks(PCA9685Servo_t *servo, int16_t angle, uint16_t *ticks)
+{
+    uint32_t range = 0U; /** Range, in tenths of a degree */
+    uint32_t position = 0U; /** Position in the table, fixed point */
+    uint32_t node = 0U; /** Table node below the angle */
+    uint32_t frac = 0U; /** Position between node and node + 1 */
+    uint32_t fixedTicks = 0U; /** Interpolated pulse width, fixed point */
+
+    /* Verifying input */
+    if (servo == NULL || ticks == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (servo->lutValid == 0U 
+        || (servo->board->modeShadowValid & PCA9685_PRESCALER_SHADOW_VALID) == 0U 
+        || servo->lutPrescaler != servo->board->prescaler)
+    {
+        if (PCA9685ServoBuildLut(servo) != PCA9685LIB_SUCCESS)
+        {
+            return PCA9685LIB_ERROR;
+        }
+    }
+
+    range = (uint32_t) servo->rangeDeg * 10U;
+
+    if (angle < 0)
+    {
+        angle = 0;
+    }
+    else if ((uint32_t) angle > range)
+    {
+        angle = (int16_t) range;
+    }
+
+    position = (((uint32_t) angle * (PCA9685_SERVO_LUT_SIZE - 1U)) << PCA9685_SERVO_LUT_FRAC_BITS) / range;
+    node = position >> PCA9685_SERVO_LUT_FRAC_BITS;
+    frac = position & ((1U << PCA9685_SERVO_LUT_FRAC_BITS) - 1U);
+
+    fixedTicks = servo->lutTicks[node];
+
+    if (node < (PCA9685_SERVO_LUT_SIZE - 1U))
+    {
+        fixedTicks = (uint32_t) ((int32_t) fixedTicks 
+                        + (int32_t) ((((int64_t) servo->lutTicks[node + 1U] - (int64_t) fixedTicks) * frac) 
+                                        >> PCA9685_SERVO_LUT_FRAC_BITS));
+    }
+
+    /* Rounding to the nearest count */
+    fixedTicks = (fixedTicks + (1U << (PCA9685_SERVO_LUT_FRAC_BITS - 1U))) >> PCA9685_SERVO_LUT_FRAC_BITS;
+
+    *ticks = (fixedTicks >= PCA9685_MAX_PWM_VALUE) ? (PCA9685_MAX_PWM_VALUE - 1U) : (uint16_t) fixedTicks;
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_ServoSetAngle(PCA9685Servo_t *servo, int16_t angle)
+{
+    PCA9685Frame_t frame = {0}; /** Single channel frame */
+    uint16_t ticks = 0U; /** Pulse width of the angle */
+
+    /* Verifying input */
+    if (servo == NULL || PCA9685_ServoAngleToTicks(servo, angle, &ticks) != PCA9685LIB_SUCCESS)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    (void) PCA9685_FrameSetDuty(&frame, servo->channel, ticks);
+
+    return PCA9685_CommitFrame(servo->board, &frame);
+}
+
+int16_t PCA9685_ServoSetAngles(PCA9685Servo_t *servos, const int16_t *angles, uint16_t count)
+{
+    PCA9685Frame_t frame; /** Frame of the board being committed */
+    PCA9685I2CConf_t *board = NULL; /** Board being committed */
+    int16_t result = PCA9685LIB_SUCCESS; /** Aggregated commit result */
+    uint16_t ticks = 0U; /** Pulse width of an angle */
+    uint16_t first = 0U; /** First servo of the board being committed */
+    uint16_t index = 0U; /** Servo index */
+
+    /* Verifying input */
+    if (servos == NULL || angles == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    for (index = 0U; index < count; index++)
+    {
+        servos[index].batchPending = 1U;
+    }
+
+    /* One frame per board, each servo visited once per board in the batch */
+    for (first = 0U; first < count; first++)
+    {
+        if (servos[first].batchPending == 0U)
+        {
+            continue;
+        }
+
+        board = servos[first].board;
+        frame.channelMask = 0U;
+
+        for (index = first; index < count; index++)
+        {
+            if (servos[index].batchPending != 0U && servos[index].board == board)
+            {
+                servos[index].batchPending = 0U;
+
+                /* A servo whose angle cannot be converted is left untouched */
+                if (PCA9685_ServoAngleToTicks(&servos[index], angles[index], &ticks) != PCA9685LIB_SUCCESS)
+                {
+                    result = PCA9685LIB_ERROR;
+                    continue;
+                }
+
+                (void) PCA9685_FrameSetDuty(&frame, servos[index].channel, ticks);
+            }
+        }
+
+        if (PCA9685_CommitFrame(board, &frame) != PCA9685LIB_SUCCESS)
+        {
+            result = PCA9685LIB_ERROR;
+        }
+    }
+
+    return result;
+}
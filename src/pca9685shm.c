@@ -0,0 +1,391 @@
+/*
+MIT License
+
+Copyright (c) 2024 Giuseppe Giglio <g.giglio001@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * \file pca9685shm.c
+ * \brief This file contains the definitions of the shared-memory frame
+ *       buffers through which client processes hand channel values to the
+ *       pca9685d daemon that owns the bus.
+ */
+
+/* Standard library includes */
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Local includes */
+#include "pca9685shm.h"
+#include "pca9685lib.h"
+#include "pca9685seqlock.h"
+
+
+
+/* Unexported functions definitions */
+
+/**
+ * \brief This function starts a write section on a frame buffer.
+ * \param [in] shared -- Pointer to the shared frame buffer.
+ * \returns Non-zero if the write section is started, zero if another process
+ *          held the buffer for PCA9685_SEQLOCK_SPINS attempts.
+ */
+uint8_t PCA9685ShmLock(PCA9685ShmFrame_t *shared)
+{
+    uint32_t self = (uint32_t) getpid(); /** Owner value of this process */
+    uint32_t spins = 0U; /** Attempts so far */
+    uint32_t expected = 0U; /** Owner of an available buffer */
+
+    for (spins = 0U; spins < PCA9685_SEQLOCK_SPINS; spins++)
+    {
+        expected = 0U;
+
+        if (__atomic_compare_exchange_n(&shared->owner, &expected, self, 0, 
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        {
+            /* Writers are serialized by owner, the counter has a single writer */
+            PCA9685SeqWriteBegin(&shared->seq);
+            return 1U;
+        }
+    }
+
+    return 0U;
+}
+
+/**
+ * \brief This function ends a write section on a frame buffer.
+ * \param [in] shared -- Pointer to the shared frame buffer.
+ */
+void PCA9685ShmUnlock(PCA9685ShmFrame_t *shared)
+{
+    __atomic_store_n(&shared->writingMask, 0U, __ATOMIC_RELAXED);
+    PCA9685SeqWriteEnd(&shared->seq);
+    __atomic_store_n(&shared->owner, 0U, __ATOMIC_RELEASE);
+}
+
+/**
+ * \brief This function releases a frame buffer held by a process that died in
+ *        its write section. The channels of that section may be half written,
+ *        they are no longer flagged. Only called by the daemon.
+ * \param [in] shared -- Pointer to the shared frame buffer.
+ * \returns PCA9685LIB_SUCCESS if the buffer was released, otherwise PCA9685LIB_ERROR
+ *          if it is available or held by a live process.
+ */
+int16_t PCA9685ShmRecover(PCA9685ShmFrame_t *shared)
+{
+    uint32_t owner = __atomic_load_n(&shared->owner, __ATOMIC_ACQUIRE); /** Holder pid */
+
+    /* Any answer but ESRCH, EPERM included, means the holder may still run */
+    if (owner == 0U || kill((pid_t) owner, 0) == 0 || errno != ESRCH)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    __atomic_fetch_and(&shared->dirtyMask, 
+                        ~__atomic_load_n(&shared->writingMask, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+    __atomic_store_n(&shared->writingMask, 0U, __ATOMIC_RELAXED);
+
+    if ((__atomic_load_n(&shared->seq, __ATOMIC_RELAXED) & 1U) != 0U)
+    {
+        PCA9685SeqWriteEnd(&shared->seq);
+    }
+
+    __atomic_store_n(&shared->owner, 0U, __ATOMIC_RELEASE);
+
+    return PCA9685LIB_SUCCESS;
+}
+
+/**
+ * \brief This function maps the frame buffer of a board.
+ * \param [out] buffer -- Pointer to the buffer mapping.
+ * \param [in] i2cDevNumber -- Linux I2C dev number of the board bus.
+ * \param [in] i2cAddress -- I2C slave address of the board.
+ * \param [in] create -- Non-zero to create and initialize the buffer.
+ * \returns PCA9685LIB_SUCCESS if the buffer is successfully mapped, otherwise PCA9685LIB_ERROR.
+ */
+int16_t PCA9685ShmMap(PCA9685ShmBuffer_t *buffer, uint16_t i2cDevNumber, uint8_t i2cAddress, 
+                        uint8_t create)
+{
+    void *map = NULL; /** Shared memory mapping */
+    int fd = -1; /** Shared memory object descriptor */
+
+    if (buffer == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    memset(buffer, 0, sizeof(PCA9685ShmBuffer_t));
+
+    (void) snprintf(buffer->name, sizeof(buffer->name), "/pca9685-i2c-%u-%02x", 
+                    (unsigned int) i2cDevNumber, (unsigned int) i2cAddress);
+
+    fd = shm_open(buffer->name, create ? (O_RDWR | O_CREAT) : O_RDWR, 0660);
+
+    if (fd < 0)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (create && ftruncate(fd, sizeof(PCA9685ShmFrame_t)) != 0)
+    {
+        close(fd);
+        return PCA9685LIB_ERROR;
+    }
+
+    map = mmap(NULL, sizeof(PCA9685ShmFrame_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    buffer->frame = (PCA9685ShmFrame_t *) map;
+    buffer->owner = create;
+
+    if (create)
+    {
+        /* Clients may still map a previous instance, keep the lock usable */
+        buffer->frame->owner = 0U;
+        buffer->frame->writingMask = 0U;
+        buffer->frame->seq &= ~1U;
+        buffer->frame->dirtyMask = 0U;
+        __atomic_store_n(&buffer->frame->magic, PCA9685_SHM_MAGIC, __ATOMIC_RELEASE);
+    }
+    else if (__atomic_load_n(&buffer->frame->magic, __ATOMIC_ACQUIRE) != PCA9685_SHM_MAGIC)
+    {
+        PCA9685_ShmClose(buffer);
+        return PCA9685LIB_ERROR;
+    }
+
+    return PCA9685LIB_SUCCESS;
+}
+
+/* Exported Functions Definitions */
+
+int16_t PCA9685_ShmCreate(PCA9685ShmBuffer_t *buffer, uint16_t i2cDevNumber, uint8_t i2cAddress)
+{
+    return PCA9685ShmMap(buffer, i2cDevNumber, i2cAddress, 1U);
+}
+
+int16_t PCA9685_ShmOpen(PCA9685ShmBuffer_t *buffer, uint16_t i2cDevNumber, uint8_t i2cAddress)
+{
+    return PCA9685ShmMap(buffer, i2cDevNumber, i2cAddress, 0U);
+}
+
+int16_t PCA9685_ShmWrite(PCA9685ShmBuffer_t *buffer, const PCA9685Frame_t *frame)
+{
+    PCA9685ShmFrame_t *shared = NULL; /** Shared frame buffer */
+    uint8_t channel = 0U; /** Channel index */
+
+    /* Verifying input */
+    if (buffer == NULL || buffer->frame == NULL || frame == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    for (channel = 0U; channel < PCA9685_MAX_PWM_CHANNELS; channel++)
+    {
+        if ((frame->channelMask & (1U << channel)) != 0U 
+                && (frame->onValue[channel] > PCA9685_MAX_PWM_VALUE 
+                    || frame->offValue[channel] > PCA9685_MAX_PWM_VALUE))
+        {
+            return PCA9685LIB_ERROR;
+        }
+    }
+
+    shared = buffer->frame;
+
+    if (PCA9685ShmLock(shared) == 0U)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    /* Flagged before the values, the daemon drops them if this process dies meanwhile */
+    __atomic_store_n(&shared->writingMask, frame->channelMask, __ATOMIC_RELAXED);
+
+    for (channel = 0U; channel < PCA9685_MAX_PWM_CHANNELS; channel++)
+    {
+        if ((frame->channelMask & (1U << channel)) != 0U)
+        {
+            shared->onValue[channel] = frame->onValue[channel];
+            shared->offValue[channel] = frame->offValue[channel];
+        }
+    }
+
+    __atomic_fetch_or(&shared->dirtyMask, frame->channelMask, __ATOMIC_RELAXED);
+
+    PCA9685ShmUnlock(shared);
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_ShmRead(PCA9685ShmBuffer_t *buffer, PCA9685Frame_t *frame)
+{
+    PCA9685ShmFrame_t *shared = NULL; /** Shared frame buffer */
+    uint32_t start = 0U; /** Sequence value at the start of the copy */
+    uint32_t attempt = 0U; /** Copy attempts */
+
+    /* Verifying input */
+    if (buffer == NULL || buffer->frame == NULL || frame == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    shared = buffer->frame;
+
+    for (attempt = 0U; attempt < PCA9685_SEQLOCK_SPINS; attempt++)
+    {
+        if (PCA9685SeqReadBegin(&shared->seq, &start) == 0U)
+        {
+            return PCA9685LIB_ERROR;
+        }
+
+        memcpy(frame->onValue, shared->onValue, sizeof(frame->onValue));
+        memcpy(frame->offValue, shared->offValue, sizeof(frame->offValue));
+
+        if (PCA9685SeqReadRetry(&shared->seq, start) == 0U)
+        {
+            frame->channelMask = 0xFFFFU;
+            return PCA9685LIB_SUCCESS;
+        }
+    }
+
+    return PCA9685LIB_ERROR;
+}
+
+int16_t PCA9685_ShmTake(PCA9685ShmBuffer_t *buffer, PCA9685Frame_t *frame)
+{
+    PCA9685ShmFrame_t *shared = NULL; /** Shared frame buffer */
+    uint16_t dirty = 0U; /** Channels taken */
+    uint16_t onValue = 0U; /** ON value of a channel */
+    uint16_t offValue = 0U; /** OFF value of a channel */
+    uint8_t channel = 0U; /** Channel index */
+
+    /* Verifying input */
+    if (buffer == NULL || buffer->frame == NULL || frame == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    shared = buffer->frame;
+
+    /* Taking the values and the dirty mask together, as a writer */
+    if (PCA9685ShmLock(shared) == 0U)
+    {
+        /* A client that died while writing would block the board forever */
+        (void) PCA9685ShmRecover(shared);
+        return PCA9685LIB_ERROR;
+    }
+
+    dirty = (uint16_t) shared->dirtyMask;
+
+    for (channel = 0U; channel < PCA9685_MAX_PWM_CHANNELS; channel++)
+    {
+        if ((dirty & (1U << channel)) != 0U)
+        {
+            /* Copied once, any process mapping the buffer may store into it */
+            onValue = shared->onValue[channel];
+            offValue = shared->offValue[channel];
+
+            /* Out of range values would make every later commit of the frame fail */
+            if (onValue > PCA9685_MAX_PWM_VALUE || offValue > PCA9685_MAX_PWM_VALUE)
+            {
+                dirty &= (uint16_t) ~(1U << channel);
+                continue;
+            }
+
+            frame->onValue[channel] = onValue;
+            frame->offValue[channel] = offValue;
+        }
+    }
+
+    shared->dirtyMask = 0U;
+
+    PCA9685ShmUnlock(shared);
+
+    frame->channelMask |= dirty;
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_ShmFlush(PCA9685ShmBuffer_t *buffer, PCA9685I2CConf_t *board)
+{
+    PCA9685Frame_t frame; /** Frame taken from the buffer */
+
+    /* Verifying input */
+    if (buffer == NULL || buffer->frame == NULL || board == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    frame.channelMask = 0U;
+
+    if (PCA9685_ShmTake(buffer, &frame) != PCA9685LIB_SUCCESS)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (frame.channelMask == 0U)
+    {
+        return PCA9685LIB_SUCCESS;
+    }
+
+    if (PCA9685_CommitFrame(board, &frame) != PCA9685LIB_SUCCESS)
+    {
+        /* Flagging the channels again so that the next flush retries them */
+        __atomic_fetch_or(&buffer->frame->dirtyMask, frame.channelMask, __ATOMIC_RELAXED);
+        return PCA9685LIB_ERROR;
+    }
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_ShmClose(PCA9685ShmBuffer_t *buffer)
+{
+
+    /* Verifying input */
+    if (buffer == NULL || buffer->frame == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (munmap(buffer->frame, sizeof(PCA9685ShmFrame_t)) != 0)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    buffer->frame = NULL;
+
+    if (buffer->owner != 0U && shm_unlink(buffer->name) != 0)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    return PCA9685LIB_SUCCESS;
+}
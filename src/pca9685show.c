@@ -0,0 +1,266 @@
+/*
+MIT License
+
+Copyright (c) 2024 Giuseppe Giglio <g.giglio001@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * \file pca9685show.c
+ * \brief This file contains the definitions of the player of precompiled
+ *       show files, streamed from a memory mapping to PCA9685 controllers.
+ */
+
+/* Standard library includes */
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Local includes */
+#include "pca9685show.h"
+#include "pca9685lib.h"
+
+
+
+/* Exported Functions Definitions */
+
+int16_t PCA9685_ShowOpen(PCA9685Show_t *show, const char *path)
+{
+    struct stat fileStat; /** Show file status */
+    void *map = NULL; /** File mapping */
+    int fd = -1; /** Show file descriptor */
+
+    /* Verifying input */
+    if (show == NULL || path == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+    /* Show files are mapped as is, without byte swapping */
+    return PCA9685LIB_ERROR;
+#endif
+
+    memset(show, 0, sizeof(PCA9685Show_t));
+
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (fstat(fd, &fileStat) != 0 || (size_t) fileStat.st_size < sizeof(PCA9685ShowHeader_t))
+    {
+        close(fd);
+        return PCA9685LIB_ERROR;
+    }
+
+    map = mmap(NULL, (size_t) fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    /* The mapping stays valid once the descriptor is closed */
+    close(fd);
+
+    if (map == MAP_FAILED)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    /* Playback is a single forward pass */
+    (void) madvise(map, (size_t) fileStat.st_size, MADV_SEQUENTIAL);
+
+    show->map = (const uint8_t *) map;
+    show->mapSize = (size_t) fileStat.st_size;
+    show->header = (const PCA9685ShowHeader_t *) map;
+    show->end = (const uint16_t *) (show->map + (show->mapSize & ~(size_t) 1U));
+
+    if (memcmp(show->header->magic, PCA9685_SHOW_MAGIC, sizeof(show->header->magic)) != 0
+            || show->header->version != PCA9685_SHOW_VERSION
+            || show->header->tickUs == 0U)
+    {
+        PCA9685_ShowClose(show);
+        return PCA9685LIB_ERROR;
+    }
+
+    return PCA9685_ShowRewind(show);
+}
+
+int16_t PCA9685_ShowRewind(PCA9685Show_t *show)
+{
+
+    /* Verifying input */
+    if (show == NULL || show->map == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    show->cursor = (const uint16_t *) (show->map + sizeof(PCA9685ShowHeader_t));
+    show->tick = 0U;
+    show->commitFailures = 0U;
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_ShowStep(PCA9685Show_t *show, PCA9685I2CConf_t **boards, PCA9685Frame_t *frames, 
+                            uint16_t boardCount)
+{
+    const uint16_t *cursor = NULL; /** Read position in the tick */
+    uint16_t recordCount = 0U; /** Number of records in the tick */
+    uint16_t record = 0U; /** Record index */
+    uint16_t board = 0U; /** Board index */
+    uint16_t mask = 0U; /** Channels of the current record */
+    uint8_t channel = 0U; /** Channel index */
+    int16_t result = PCA9685LIB_SUCCESS; /** Aggregated commit result */
+
+    /* Verifying input */
+    if (show == NULL || show->map == NULL || boards == NULL || frames == NULL 
+            || boardCount < show->header->boardCount)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (show->tick >= show->header->tickCount)
+    {
+        return PCA9685_SHOW_END;
+    }
+
+    cursor = show->cursor;
+
+    if (cursor >= show->end)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    recordCount = *cursor++;
+
+    for (board = 0U; board < show->header->boardCount; board++)
+    {
+        frames[board].channelMask = 0U;
+    }
+
+    /* Records are copied straight from the mapping, only bounds are checked */
+    for (record = 0U; record < recordCount; record++)
+    {
+        if ((cursor + 2) > show->end)
+        {
+            return PCA9685LIB_ERROR;
+        }
+
+        board = cursor[0];
+        mask = cursor[1];
+        cursor += 2;
+
+        if (board >= show->header->boardCount 
+                || (cursor + __builtin_popcount(mask)) > show->end)
+        {
+            return PCA9685LIB_ERROR;
+        }
+
+        for (channel = 0U; mask != 0U; channel++, mask >>= 1U)
+        {
+            if ((mask & 1U) != 0U)
+            {
+                if (PCA9685_FrameSetDuty(&frames[board], channel, *cursor++) != PCA9685LIB_SUCCESS)
+                {
+                    return PCA9685LIB_ERROR;
+                }
+            }
+        }
+    }
+
+    show->cursor = cursor;
+    show->tick++;
+
+    for (board = 0U; board < show->header->boardCount; board++)
+    {
+        if (frames[board].channelMask == 0U)
+        {
+            continue;
+        }
+
+        /* One board failing must not end the show, the next ticks are still played */
+        if (PCA9685_CommitFrame(boards[board], &frames[board]) != PCA9685LIB_SUCCESS)
+        {
+            show->commitFailures++;
+            result = PCA9685_SHOW_COMMIT_FAILED;
+        }
+    }
+
+    return result;
+}
+
+int16_t PCA9685_ShowPlay(PCA9685Show_t *show, PCA9685I2CConf_t **boards, PCA9685Frame_t *frames, 
+                            uint16_t boardCount)
+{
+    struct timespec deadline; /** Absolute time of the next tick */
+    int16_t result = PCA9685LIB_SUCCESS; /** Step result */
+
+    /* Verifying input */
+    if (show == NULL || show->map == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+    while ((result = PCA9685_ShowStep(show, boards, frames, boardCount)) == PCA9685LIB_SUCCESS 
+            || result == PCA9685_SHOW_COMMIT_FAILED)
+    {
+        /* Ticks may last seconds, their nanoseconds would overflow a 32-bit long */
+        deadline.tv_sec += (time_t) (show->header->tickUs / 1000000U);
+        deadline.tv_nsec += (long) (show->header->tickUs % 1000000U) * 1000L;
+
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_nsec -= 1000000000L;
+            deadline.tv_sec++;
+        }
+
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR)
+        {
+        }
+    }
+
+    return (result == PCA9685_SHOW_END) ? PCA9685LIB_SUCCESS : PCA9685LIB_ERROR;
+}
+
+int16_t PCA9685_ShowClose(PCA9685Show_t *show)
+{
+
+    /* Verifying input */
+    if (show == NULL || show->map == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (munmap((void *) show->map, show->mapSize) != 0)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    memset(show, 0, sizeof(PCA9685Show_t));
+
+    return PCA9685LIB_SUCCESS;
+}
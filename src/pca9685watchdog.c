@@ -0,0 +1,286 @@
+/*
+MIT License
+
+Copyright (c) 2024 Giuseppe Giglio <g.giglio001@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * \file pca9685watchdog.c
+ * \brief This file contains the definitions of the safety watchdog, which
+ *       drives the boards to a fail-safe state when the application stops
+ *       kicking it.
+ */
+
+/* Standard library includes */
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+/* Local includes */
+#include "pca9685watchdog.h"
+#include "pca9685lib.h"
+#include "pca9685buslock.h"
+
+
+/* Unexported functions definitions */
+
+/**
+ * \brief This function sets the deadline one timeout from now. Called with the
+ *        watchdog lock held.
+ * \param [in] watchdog -- Pointer to the watchdog.
+ */
+void PCA9685WatchdogArm(PCA9685Watchdog_t *watchdog)
+{
+    uint64_t deadlineNs = 0U; /** Deadline, in nanoseconds */
+
+    deadlineNs = PCA9685MonotonicNs() + ((uint64_t) watchdog->timeoutMs * 1000000U);
+
+    watchdog->deadline.tv_sec = (time_t) (deadlineNs / 1000000000U);
+    watchdog->deadline.tv_nsec = (long) (deadlineNs % 1000000000U);
+    watchdog->tripped = 0U;
+}
+
+/**
+ * \brief This function is the body of the watchdog thread. It sleeps until the
+ *        deadline, and writes the fail-safe state of every board if it passes
+ *        without a kick.
+ * \param [in] argument -- Pointer to the watchdog.
+ * \returns NULL.
+ */
+void *PCA9685WatchdogThread(void *argument)
+{
+    PCA9685Watchdog_t *watchdog = (PCA9685Watchdog_t *) argument; /** Watchdog of the thread */
+    uint32_t i = 0U; /** Board index */
+    int16_t status = PCA9685LIB_SUCCESS; /** Trip status */
+
+    pthread_mutex_lock(&watchdog->mutex);
+
+    while (watchdog->running != 0U)
+    {
+        if (watchdog->tripped != 0U)
+        {
+            pthread_cond_wait(&watchdog->kicked, &watchdog->mutex);
+            continue;
+        }
+
+        /* A kick moves the deadline, which is checked again on wake up */
+        if (pthread_cond_timedwait(&watchdog->kicked, &watchdog->mutex, 
+                                    &watchdog->deadline) != ETIMEDOUT)
+        {
+            continue;
+        }
+
+        /* The timeout may race with a kick made right at the deadline */
+        if (PCA9685MonotonicNs() < ((uint64_t) watchdog->deadline.tv_sec * 1000000000U) 
+                                        + (uint64_t) watchdog->deadline.tv_nsec)
+        {
+            continue;
+        }
+
+        watchdog->tripped = 1U;
+        watchdog->trips++;
+
+        status = PCA9685LIB_SUCCESS;
+
+        /* A kick between two boards means the application is back, its boards are left alone */
+        for (i = 0U; i < watchdog->boardCount && watchdog->tripped != 0U; i++)
+        {
+            /* The mutex is held per board so that a kick waits at most for one write */
+            if (PCA9685_WriteFailSafe(watchdog->boards[i], watchdog->failSafe[i], 
+                                        watchdog->actions) != PCA9685LIB_SUCCESS)
+            {
+                status = PCA9685LIB_ERROR;
+            }
+
+            pthread_mutex_unlock(&watchdog->mutex);
+            pthread_mutex_lock(&watchdog->mutex);
+        }
+
+        watchdog->tripStatus = status;
+    }
+
+    pthread_mutex_unlock(&watchdog->mutex);
+
+    return NULL;
+}
+
+
+/* Exported Functions Definitions */
+
+int16_t PCA9685_WatchdogInit(PCA9685Watchdog_t *watchdog, uint32_t timeoutMs, uint8_t actions)
+{
+    pthread_condattr_t attributes; /** Condition attributes, for the monotonic clock */
+
+    /* Verifying input */
+    if (watchdog == NULL || timeoutMs == 0U)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    memset(watchdog, 0, sizeof(PCA9685Watchdog_t));
+
+    watchdog->timeoutMs = timeoutMs;
+    watchdog->actions = (uint8_t) (actions & (PCA9685_SAFETY_DISABLE_OUTPUT | PCA9685_SAFETY_SLEEP));
+    watchdog->tripStatus = PCA9685LIB_SUCCESS;
+
+    if (pthread_mutex_init(&watchdog->mutex, NULL) != 0)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    /* Deadlines must not move with the wall clock */
+    if (pthread_condattr_init(&attributes) != 0)
+    {
+        pthread_mutex_destroy(&watchdog->mutex);
+        return PCA9685LIB_ERROR;
+    }
+
+    if (pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC) != 0 
+            || pthread_cond_init(&watchdog->kicked, &attributes) != 0)
+    {
+        pthread_condattr_destroy(&attributes);
+        pthread_mutex_destroy(&watchdog->mutex);
+        return PCA9685LIB_ERROR;
+    }
+
+    pthread_condattr_destroy(&attributes);
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_WatchdogAddBoard(PCA9685Watchdog_t *watchdog, PCA9685I2CConf_t *board, 
+                                    const PCA9685Frame_t *failSafe)
+{
+    PCA9685Frame_t allOff; /** Default fail-safe frame */
+
+    /* Verifying input */
+    if (watchdog == NULL || board == NULL || watchdog->running != 0U 
+            || watchdog->boardCount >= PCA9685_WATCHDOG_MAX_BOARDS)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    if (failSafe == NULL)
+    {
+        /* No channel in the mask, every channel full OFF */
+        memset(&allOff, 0, sizeof(allOff));
+        failSafe = &allOff;
+    }
+
+    if (PCA9685_FrameToRegs(failSafe, watchdog->failSafe[watchdog->boardCount]) != PCA9685LIB_SUCCESS 
+            || PCA9685_SetThreadSafe(board, 1U) != PCA9685LIB_SUCCESS)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    watchdog->boards[watchdog->boardCount] = board;
+    watchdog->boardCount++;
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_WatchdogStart(PCA9685Watchdog_t *watchdog)
+{
+
+    /* Verifying input */
+    if (watchdog == NULL || watchdog->running != 0U)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    PCA9685WatchdogArm(watchdog);
+    watchdog->running = 1U;
+
+    if (pthread_create(&watchdog->thread, NULL, PCA9685WatchdogThread, watchdog) != 0)
+    {
+        watchdog->running = 0U;
+        return PCA9685LIB_ERROR;
+    }
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_WatchdogKick(PCA9685Watchdog_t *watchdog)
+{
+
+    /* Verifying input */
+    if (watchdog == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    pthread_mutex_lock(&watchdog->mutex);
+
+    /* The thread only needs waking up to leave the tripped state */
+    if (watchdog->tripped != 0U)
+    {
+        pthread_cond_signal(&watchdog->kicked);
+    }
+
+    PCA9685WatchdogArm(watchdog);
+
+    pthread_mutex_unlock(&watchdog->mutex);
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_WatchdogGetTrips(PCA9685Watchdog_t *watchdog, uint64_t *trips, int16_t *tripStatus)
+{
+
+    /* Verifying input */
+    if (watchdog == NULL || trips == NULL)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    pthread_mutex_lock(&watchdog->mutex);
+
+    *trips = watchdog->trips;
+
+    if (tripStatus != NULL)
+    {
+        *tripStatus = watchdog->tripStatus;
+    }
+
+    pthread_mutex_unlock(&watchdog->mutex);
+
+    return PCA9685LIB_SUCCESS;
+}
+
+int16_t PCA9685_WatchdogStop(PCA9685Watchdog_t *watchdog)
+{
+
+    /* Verifying input */
+    if (watchdog == NULL || watchdog->running == 0U)
+    {
+        return PCA9685LIB_ERROR;
+    }
+
+    pthread_mutex_lock(&watchdog->mutex);
+    watchdog->running = 0U;
+    pthread_cond_signal(&watchdog->kicked);
+    pthread_mutex_unlock(&watchdog->mutex);
+
+    pthread_join(watchdog->thread, NULL);
+
+    return PCA9685LIB_SUCCESS;
+}